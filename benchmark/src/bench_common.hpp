@@ -0,0 +1,236 @@
+#pragma once
+
+#include "ws_common/logger.hpp"
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace KK_WS::bench {
+
+/**
+ * @brief 一次压测的结果
+ */
+struct LoadResult {
+    uint64_t messages = 0;   // 收到的回显消息数
+    uint64_t bytes = 0;      // 收到的回显字节数
+    double seconds = 0.0;    // 实际测量时长
+    double cpu_seconds = 0.0; // 进程CPU时间（客户端+服务器同进程）
+
+    double msgs_per_sec() const { return seconds > 0 ? messages / seconds : 0.0; }
+    double mb_per_sec() const { return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+};
+
+// 进程CPU时间（秒）
+inline double process_cpu_seconds() {
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief 闭环回显负载
+ *
+ * 在一个websocketpp客户端endpoint上建立多个连接，每个连接收到回显后
+ * 立即再次发送同一负载，测量固定时长内的往返消息数。
+ * Config为客户端websocketpp配置，例如启用压缩扩展的配置。
+ */
+template <typename Config>
+class BasicEchoLoad {
+public:
+    using client_type = websocketpp::client<Config>;
+
+    BasicEchoLoad(size_t io_threads, std::string payload)
+        : io_thread_count_(io_threads), payload_(std::move(payload)) {
+        client_.clear_access_channels(websocketpp::log::alevel::all);
+        client_.clear_error_channels(websocketpp::log::elevel::all);
+        client_.init_asio();
+        client_.start_perpetual();
+
+        client_.set_open_handler([this](websocketpp::connection_hdl hdl) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                handles_.push_back(hdl);
+            }
+            opened_++;
+        });
+
+        client_.set_fail_handler([this](websocketpp::connection_hdl) {
+            failed_++;
+        });
+
+        client_.set_message_handler([this](websocketpp::connection_hdl hdl,
+                                           typename client_type::message_ptr msg) {
+            messages_++;
+            bytes_ += msg->get_payload().size();
+            if (verifying_ && msg->get_payload() != payload_) {
+                mismatched_++;
+            }
+
+            if (measuring_) {
+                websocketpp::lib::error_code ec;
+                client_.send(hdl, payload_, websocketpp::frame::opcode::text, ec);
+            }
+        });
+
+        for (size_t i = 0; i < io_thread_count_; ++i) {
+            threads_.emplace_back([this]() { client_.run(); });
+        }
+    }
+
+    ~BasicEchoLoad() {
+        close_all();
+        client_.stop_perpetual();
+        for (auto& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    // 建立connections个连接，返回成功建立的连接数
+    size_t open(const std::string& uri, size_t connections,
+                std::chrono::milliseconds timeout = std::chrono::seconds(30)) {
+        for (size_t i = 0; i < connections; ++i) {
+            websocketpp::lib::error_code ec;
+            auto con = client_.get_connection(uri, ec);
+            if (ec) {
+                Logger::error("创建压测连接失败: " + ec.message());
+                break;
+            }
+            client_.connect(con);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (opened_ + failed_ < connections && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return opened_;
+    }
+
+    // 所有连接各发送一条消息后保持闭环，测量duration时长
+    LoadResult run(std::chrono::milliseconds duration) {
+        std::vector<websocketpp::connection_hdl> handles;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handles = handles_;
+        }
+
+        messages_ = 0;
+        bytes_ = 0;
+        measuring_ = true;
+
+        auto cpu_start = process_cpu_seconds();
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto& hdl : handles) {
+            websocketpp::lib::error_code ec;
+            client_.send(hdl, payload_, websocketpp::frame::opcode::text, ec);
+        }
+
+        std::this_thread::sleep_for(duration);
+
+        LoadResult result;
+        result.messages = messages_;
+        result.bytes = bytes_;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.cpu_seconds = process_cpu_seconds() - cpu_start;
+        measuring_ = false;
+        return result;
+    }
+
+    // 每个连接发送一条消息并等待回显，回显负载与发送的完全一致时返回true。
+    // 压缩场景下校验的是两个方向在线路上的真实帧：客户端压缩 -> 服务器解压，服务器压缩 -> 客户端解压
+    bool verify_echo(std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+        std::vector<websocketpp::connection_hdl> handles;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handles = handles_;
+        }
+
+        messages_ = 0;
+        mismatched_ = 0;
+        verifying_ = true;
+
+        for (auto& hdl : handles) {
+            websocketpp::lib::error_code ec;
+            client_.send(hdl, payload_, websocketpp::frame::opcode::text, ec);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (messages_ < handles.size() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        verifying_ = false;
+        return !handles.empty() && messages_ == handles.size() && mismatched_ == 0;
+    }
+
+    // 只接收不回显时使用：清零并读取收到的消息数
+    void reset_received() {
+        messages_ = 0;
+        bytes_ = 0;
+    }
+
+    uint64_t received() const { return messages_; }
+
+    void close_all() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& hdl : handles_) {
+            websocketpp::lib::error_code ec;
+            client_.close(hdl, websocketpp::close::status::normal, "", ec);
+        }
+        handles_.clear();
+    }
+
+    client_type& endpoint() { return client_; }
+
+private:
+    client_type client_;
+    size_t io_thread_count_;
+    std::string payload_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::vector<websocketpp::connection_hdl> handles_;
+
+    std::atomic<size_t> opened_{0};
+    std::atomic<size_t> failed_{0};
+    std::atomic<bool> measuring_{false};
+    std::atomic<bool> verifying_{false};
+    std::atomic<uint64_t> mismatched_{0};
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+using EchoLoad = BasicEchoLoad<websocketpp::config::asio_client>;
+
+// 提高文件描述符上限，单进程内同时承载上万个客户端和服务器连接
+inline void raise_fd_limit() {
+#ifdef __linux__
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+
+// 解析第index个命令行参数，缺省时返回default_value
+inline size_t arg_or(int argc, char* argv[], int index, size_t default_value) {
+    if (argc > index) {
+        try {
+            return static_cast<size_t>(std::stoul(argv[index]));
+        } catch (...) {
+        }
+    }
+    return default_value;
+}
+
+} // namespace KK_WS::bench
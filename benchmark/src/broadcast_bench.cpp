@@ -0,0 +1,111 @@
+// 广播性能：逐连接send_message（每个接收者单独分帧拷贝） vs broadcast（编码一次共享帧）
+//
+// 用法: broadcast_bench [轮数=20] [消息字节=256] [端口=9110]
+// 依次在1k和10k个连接上测量，10k连接需要约2万个文件描述符。
+
+#include "bench_common.hpp"
+#include "ws_server/server.hpp"
+#include <cstdio>
+
+using namespace KK_WS;
+
+namespace {
+
+struct BroadcastResult {
+    double per_recipient_seconds = 0.0;
+    double encode_once_seconds = 0.0;
+};
+
+// 发送rounds轮，等待所有客户端收到后返回耗时
+template <typename SendRound>
+double timed_rounds(bench::EchoLoad& load, size_t connections, size_t rounds, SendRound send_round) {
+    load.reset_received();
+    const uint64_t expected = static_cast<uint64_t>(connections) * rounds;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        send_round();
+    }
+
+    auto deadline = start + std::chrono::seconds(120);
+    while (load.received() < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    if (load.received() < expected) {
+        std::printf("  警告: 仅收到 %llu/%llu 条消息\n",
+                    static_cast<unsigned long long>(load.received()),
+                    static_cast<unsigned long long>(expected));
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+BroadcastResult run(size_t connections, size_t rounds, size_t message_size, uint16_t port) {
+    server::ServerConfig config;
+    config.port = port;
+    config.enable_logging = false;
+    config.io_threads = 4;
+
+    server::WebSocketServer srv(config);
+
+    std::mutex hdl_mutex;
+    std::vector<server::connection_hdl> handles;
+    srv.set_open_handler([&](server::connection_hdl hdl) {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        handles.push_back(hdl);
+    });
+
+    std::thread server_thread([&srv]() { srv.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    BroadcastResult result;
+    {
+        bench::EchoLoad load(4, std::string());
+        load.open("ws://127.0.0.1:" + std::to_string(port), connections, std::chrono::seconds(120));
+
+        std::vector<server::connection_hdl> targets;
+        {
+            std::lock_guard<std::mutex> lock(hdl_mutex);
+            targets = handles;
+        }
+
+        const std::string message(message_size, 'b');
+
+        result.per_recipient_seconds = timed_rounds(load, targets.size(), rounds, [&]() {
+            for (auto& hdl : targets) {
+                srv.send_message(hdl, message);
+            }
+        });
+
+        result.encode_once_seconds = timed_rounds(load, targets.size(), rounds, [&]() {
+            srv.broadcast(message);
+        });
+    }
+
+    srv.stop();
+    server_thread.join();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::set_level(Logger::Level::Ws_WARNING);
+    bench::raise_fd_limit();
+
+    const size_t rounds = bench::arg_or(argc, argv, 1, 20);
+    const size_t message_size = bench::arg_or(argc, argv, 2, 256);
+    const auto port = static_cast<uint16_t>(bench::arg_or(argc, argv, 3, 9110));
+
+    std::printf("轮数: %zu, 消息大小: %zu 字节\n", rounds, message_size);
+    std::printf("%10s %18s %18s %8s\n", "连接数", "逐连接(msg/s)", "编码一次(msg/s)", "加速比");
+
+    uint16_t next_port = port;
+    for (size_t connections : {size_t(1000), size_t(10000)}) {
+        auto r = run(connections, rounds, message_size, next_port++);
+        const double delivered = static_cast<double>(connections) * rounds;
+        const double before = delivered / r.per_recipient_seconds;
+        const double after = delivered / r.encode_once_seconds;
+        std::printf("%10zu %18.0f %18.0f %7.2fx\n", connections, before, after, after / before);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// permessage-deflate：未压缩 vs 不同压缩级别的回显吞吐与CPU开销
+//
+// 用法: compression_bench [连接数=16] [消息字节=4096] [秒数=5] [端口=9120]
+// 负载为可压缩的JSON文本；压缩率为单条消息独立压缩（no_context_takeover）时的估算值。
+// 测量前先校验每个连接的回显与发送内容一致（两个方向的压缩帧都经过真实的分帧与解压），
+// 任一场景校验失败时返回非0。
+
+#include "bench_common.hpp"
+#include "ws_server/server.hpp"
+#include "ws_core/permessage_deflate.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdio>
+
+using namespace KK_WS;
+
+namespace {
+
+// 压测客户端同样使用可配置的压缩扩展
+struct deflate_client_config : public websocketpp::config::asio_client {
+    typedef core::deflate::extension<core::deflate::client_role> permessage_deflate_type;
+};
+
+using DeflateEchoLoad = bench::BasicEchoLoad<deflate_client_config>;
+
+struct Scenario {
+    const char* name;
+    bool enabled;
+    int level;
+};
+
+// 生成接近真实业务消息的JSON负载
+std::string make_payload(size_t size) {
+    std::string payload = "[";
+    for (size_t i = 0; payload.size() < size; ++i) {
+        payload += "{\"id\":" + std::to_string(i) +
+                   ",\"symbol\":\"SYM" + std::to_string(i % 32) +
+                   "\",\"price\":" + std::to_string(100 + (i * 7) % 50) +
+                   ".25,\"qty\":" + std::to_string((i * 13) % 1000) + "},";
+    }
+    payload.resize(size - 1);
+    payload += "]";
+    return payload;
+}
+
+// 单条消息的压缩后大小（原始deflate，与扩展相同的参数）
+size_t deflated_size(const std::string& payload, int level) {
+    z_stream zs{};
+    if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return payload.size();
+    }
+    std::string out(deflateBound(&zs, payload.size()) + 16, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data()));
+    zs.avail_in = static_cast<uInt>(payload.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    ::deflate(&zs, Z_SYNC_FLUSH);
+    const size_t size = out.size() - zs.avail_out - 4;
+    deflateEnd(&zs);
+    return size;
+}
+
+bench::LoadResult run(const Scenario& scenario, size_t connections, size_t seconds,
+                      const std::string& payload, uint16_t port, bool& verified) {
+    ws_compression_config compression;
+    compression.enabled = scenario.enabled;
+    compression.level = scenario.level;
+    compression.min_size = 0;
+
+    server::ServerConfig config;
+    config.port = port;
+    config.enable_logging = false;
+    config.io_threads = 2;
+    config.compression = compression;
+
+    server::WebSocketServer srv(config);
+    std::thread server_thread([&srv]() { srv.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    bench::LoadResult result;
+    {
+        DeflateEchoLoad load(2, payload);
+        // 压缩参数在每个连接创建协议处理器之前绑定到其I/O线程
+        load.endpoint().set_tcp_post_init_handler([compression](websocketpp::connection_hdl) {
+            core::deflate::extension<core::deflate::client_role>::bind_to_thread(compression);
+        });
+        if (load.open("ws://127.0.0.1:" + std::to_string(port), connections) < connections) {
+            std::printf("  警告: 未能建立全部 %zu 个连接\n", connections);
+        }
+        verified = load.verify_echo();
+        if (!verified) {
+            std::printf("  错误: %s 回显内容与发送内容不一致\n", scenario.name);
+        }
+        result = load.run(std::chrono::seconds(seconds));
+    }
+
+    srv.stop();
+    server_thread.join();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::set_level(Logger::Level::Ws_WARNING);
+
+    const size_t connections = bench::arg_or(argc, argv, 1, 16);
+    const size_t message_size = std::max<size_t>(64, bench::arg_or(argc, argv, 2, 4096));
+    const size_t seconds = bench::arg_or(argc, argv, 3, 5);
+    const auto port = static_cast<uint16_t>(bench::arg_or(argc, argv, 4, 9120));
+
+    const std::string payload = make_payload(message_size);
+    const Scenario scenarios[] = {
+        {"未压缩", false, 0},
+        {"deflate level 1", true, 1},
+        {"deflate level 6", true, 6},
+        {"deflate level 9", true, 9},
+    };
+
+    std::printf("连接数: %zu, 消息大小: %zu 字节, 每项 %zu 秒\n", connections, message_size, seconds);
+    std::printf("%-18s %12s %10s %16s %10s\n", "模式", "msg/s", "MB/s", "CPU(us/往返)", "压缩率");
+
+    uint16_t next_port = port;
+    bool all_verified = true;
+    for (const auto& scenario : scenarios) {
+        bool verified = false;
+        auto r = run(scenario, connections, seconds, payload, next_port++, verified);
+        all_verified = all_verified && verified;
+        const double cpu_us = r.messages ? r.cpu_seconds * 1e6 / r.messages : 0.0;
+        const double ratio = scenario.enabled
+            ? static_cast<double>(deflated_size(payload, scenario.level)) / payload.size()
+            : 1.0;
+        std::printf("%-18s %12.0f %10.1f %16.2f %9.1f%%\n",
+                    scenario.name, r.msgs_per_sec(), r.mb_per_sec(), cpu_us, ratio * 100.0);
+    }
+    return all_verified ? 0 : 1;
+}
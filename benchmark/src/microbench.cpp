@@ -0,0 +1,267 @@
+// 热路径微基准：ws_message构造与拷贝、Logger开启/关闭级别、WebSocketServer::broadcast、
+// ClientManager::get_client并发查找、core::Connection收发往返
+//
+// 找到Google Benchmark时链接它（支持--benchmark_filter等参数），否则使用mini_benchmark.hpp。
+// 涉及网络的用例在进程内启动服务器，端口从9300起递增。
+
+#ifdef WS_MINI_BENCHMARK
+#include "mini_benchmark.hpp"
+#else
+#include <benchmark/benchmark.h>
+#endif
+
+#include "bench_common.hpp"
+#include "ws_server/server.hpp"
+#include "ws_client/client.hpp"
+#include "ws_core/connection.hpp"
+
+using namespace KK_WS;
+
+namespace {
+
+uint16_t next_port() {
+    static std::atomic<uint16_t> port{9300};
+    return port++;
+}
+
+// 等待计数达到target，超时返回false
+bool wait_for(const std::atomic<uint64_t>& counter, uint64_t target,
+              std::chrono::seconds timeout = std::chrono::seconds(10)) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (counter.load(std::memory_order_acquire) < target) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/**
+ * @brief 进程内的回显服务器（不设置消息处理器，默认原样回显）
+ */
+class InProcessServer {
+public:
+    InProcessServer()
+        : port_(next_port())
+        , server_(make_config(port_))
+        , thread_([this]() { server_.start(); }) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    ~InProcessServer() {
+        server_.stop();
+        thread_.join();
+    }
+
+    server::WebSocketServer& server() { return server_; }
+    std::string uri() const { return "ws://127.0.0.1:" + std::to_string(port_); }
+
+private:
+    static server::ServerConfig make_config(uint16_t port) {
+        server::ServerConfig config;
+        config.port = port;
+        config.enable_logging = false;
+        config.io_threads = 2;
+        return config;
+    }
+
+    uint16_t port_;
+    server::WebSocketServer server_;
+    std::thread thread_;
+};
+
+// ========== ws_message ==========
+
+void BM_MessageConstruct(benchmark::State& state) {
+    const std::string payload(static_cast<size_t>(state.range(0)), 'm');
+    for (auto _ : state) {
+        ws_message message(ws_message::message_type::TEXT, payload);
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_MessageConstruct)->Arg(16)->Arg(1024)->Arg(65536);
+
+void BM_MessageCopy(benchmark::State& state) {
+    const ws_message original(ws_message::message_type::BINARY,
+                              std::string(static_cast<size_t>(state.range(0)), 'm'));
+    for (auto _ : state) {
+        ws_message copy(original);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_MessageCopy)->Arg(16)->Arg(1024)->Arg(65536);
+
+void BM_MessageMove(benchmark::State& state) {
+    ws_message message(ws_message::message_type::BINARY,
+                       std::string(static_cast<size_t>(state.range(0)), 'm'));
+    for (auto _ : state) {
+        ws_message moved(std::move(message));
+        benchmark::DoNotOptimize(moved);
+        message = std::move(moved);
+    }
+}
+BENCHMARK(BM_MessageMove)->Arg(1024);
+
+// ========== Logger ==========
+
+// 日志用例关闭控制台输出，只测量格式化与加锁开销，不含终端I/O。
+// 多线程用例中各线程退出循环的时间不同，用例结束时不恢复设置，由后续用例各自设置
+void set_logging(Logger::Level level, bool console) {
+    Logger::set_console_output(console);
+    Logger::set_level(level);
+}
+
+void BM_LoggerEnabled(benchmark::State& state) {
+    set_logging(Logger::Level::Ws_INFO, false);
+    const std::string message(64, 'l');
+    for (auto _ : state) {
+        Logger::info(message);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LoggerEnabled)->Threads(1)->Threads(4)->UseRealTime();
+
+void BM_LoggerEnabledFormat(benchmark::State& state) {
+    set_logging(Logger::Level::Ws_INFO, false);
+    const std::string message(64, 'l');
+    for (auto _ : state) {
+        Logger::infof("收到消息: {} ({} 字节)", Logger::preview(message, 32), message.size());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LoggerEnabledFormat);
+
+// 级别关闭时，字符串参数仍会在调用处拷贝一次
+void BM_LoggerDisabled(benchmark::State& state) {
+    set_logging(Logger::Level::Ws_WARNING, false);
+    const std::string message(64, 'l');
+    for (auto _ : state) {
+        Logger::info(message);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LoggerDisabled);
+
+// 格式化风格的日志先检查级别，关闭时不拼接、不分配
+void BM_LoggerDisabledFormat(benchmark::State& state) {
+    set_logging(Logger::Level::Ws_WARNING, false);
+    const std::string message(64, 'l');
+    for (auto _ : state) {
+        Logger::infof("收到消息: {} ({} 字节)", Logger::preview(message, 32), message.size());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LoggerDisabledFormat);
+
+// ========== WebSocketServer::broadcast ==========
+
+// 每次迭代广播一条消息并等待所有连接收到
+void BM_Broadcast(benchmark::State& state) {
+    set_logging(Logger::Level::Ws_WARNING, true);
+    const size_t connections = static_cast<size_t>(state.range(0));
+
+    InProcessServer srv;
+    bench::EchoLoad load(2, std::string());
+    if (load.open(srv.uri(), connections) < connections) {
+        state.SkipWithError("建立连接失败");
+        return;
+    }
+    while (srv.server().get_connection_count() < connections) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const std::string message(256, 'b');
+    load.reset_received();
+    uint64_t expected = 0;
+
+    for (auto _ : state) {
+        srv.server().broadcast(message);
+        expected += connections;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (load.received() < expected && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        if (load.received() < expected) {
+            state.SkipWithError("广播消息未全部送达");
+            break;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * connections));
+}
+BENCHMARK(BM_Broadcast)->Arg(10)->Arg(100)->Arg(1000)->UseRealTime();
+
+// ========== ClientManager::get_client ==========
+
+// 所有线程共享的1000个已注册客户端（只创建一次，不连接）
+const std::vector<std::string>& managed_client_ids() {
+    static const std::vector<std::string> ids = []() {
+        set_logging(Logger::Level::Ws_WARNING, true);
+        std::vector<std::string> result;
+        for (size_t i = 0; i < 1000; ++i) {
+            result.push_back("microbench_" + std::to_string(i));
+            client::ClientManager::instance().create_client(result.back());
+        }
+        return result;
+    }();
+    return ids;
+}
+
+void BM_ClientManagerGetClient(benchmark::State& state) {
+    const auto& ids = managed_client_ids();
+    auto& manager = client::ClientManager::instance();
+
+    size_t index = static_cast<size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        auto client = manager.get_client(ids[index++ % ids.size()]);
+        benchmark::DoNotOptimize(client);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_ClientManagerGetClient)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+// ========== core::Connection ==========
+
+// 发送一条消息并等待服务器回显，测量单条消息的往返时间
+void BM_ConnectionRoundTrip(benchmark::State& state) {
+    set_logging(Logger::Level::Ws_WARNING, true);
+    InProcessServer srv;
+
+    ws_config config;
+    config.uri = srv.uri();
+    config.enable_auto_reconnect = false;
+    config.ping_interval_ms = 0;
+
+    std::atomic<uint64_t> received{0};
+    auto connection = core::create_connection(config);
+    connection->set_message_callback(MessageViewCallback([&received](const ws_message_view&) {
+        received.fetch_add(1, std::memory_order_release);
+    }));
+    if (!connection->connect(config)) {
+        state.SkipWithError("连接失败");
+        return;
+    }
+
+    const std::string payload(static_cast<size_t>(state.range(0)), 'r');
+    uint64_t expected = 0;
+
+    for (auto _ : state) {
+        connection->send_message(ws_message(ws_message::message_type::BINARY, std::string(payload)));
+        if (!wait_for(received, ++expected)) {
+            state.SkipWithError("回显超时");
+            break;
+        }
+    }
+
+    connection->disconnect();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) * 2);
+}
+BENCHMARK(BM_ConnectionRoundTrip)->Arg(64)->Arg(4096)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
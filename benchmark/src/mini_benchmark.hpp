@@ -0,0 +1,235 @@
+#pragma once
+
+// 未找到Google Benchmark时使用的最小替代实现
+//
+// 只实现microbench.cpp用到的子集：State的范围for循环、range()、thread_index()、
+// SetItemsProcessed/SetBytesProcessed/SkipWithError，注册时的Arg()/Threads()/UseRealTime()，
+// 以及DoNotOptimize和BENCHMARK/BENCHMARK_MAIN宏。
+// 迭代次数自动增长到单次运行不少于kMinTime，多线程时每个线程执行相同次数，
+// 结果按墙钟时间计算每次迭代的耗时。
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace benchmark {
+
+class State {
+public:
+    State(uint64_t iterations, std::vector<int64_t> args, int thread_index, int threads)
+        : iterations_(iterations), args_(std::move(args)), thread_index_(thread_index), threads_(threads) {}
+
+    class iterator {
+    public:
+        explicit iterator(uint64_t remaining) : remaining_(remaining) {}
+        bool operator!=(const iterator&) const { return remaining_ != 0; }
+        void operator++() { --remaining_; }
+#if defined(__GNUC__) || defined(__clang__)
+        struct __attribute__((unused)) Value {};
+#else
+        struct Value {};
+#endif
+        Value operator*() const { return {}; }
+
+    private:
+        uint64_t remaining_;
+    };
+
+    iterator begin() { return iterator(iterations_); }
+    iterator end() { return iterator(0); }
+
+    int64_t range(size_t index = 0) const { return index < args_.size() ? args_[index] : 0; }
+    int thread_index() const { return thread_index_; }
+    int threads() const { return threads_; }
+    uint64_t iterations() const { return iterations_; }
+
+    void SetItemsProcessed(int64_t items) { items_ = items; }
+    void SetBytesProcessed(int64_t bytes) { bytes_ = bytes; }
+    int64_t items_processed() const { return items_; }
+    int64_t bytes_processed() const { return bytes_; }
+
+    // 与Google Benchmark相同，调用后不应再进入迭代循环
+    void SkipWithError(const char* message) { error_ = message; }
+    const std::string& error() const { return error_; }
+
+private:
+    uint64_t iterations_;
+    std::vector<int64_t> args_;
+    int thread_index_;
+    int threads_;
+    int64_t items_ = 0;
+    int64_t bytes_ = 0;
+    std::string error_;
+};
+
+template <typename T>
+inline void DoNotOptimize(T&& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+namespace internal {
+
+using Function = void (*)(State&);
+
+class Benchmark {
+public:
+    Benchmark(std::string name, Function fn) : name_(std::move(name)), fn_(fn) {}
+
+    Benchmark* Arg(int64_t arg) {
+        args_.push_back(arg);
+        return this;
+    }
+
+    Benchmark* Threads(int threads) {
+        threads_.push_back(std::max(1, threads));
+        return this;
+    }
+
+    Benchmark* UseRealTime() { return this; }
+
+    void run() const {
+        const std::vector<int64_t> args = args_.empty() ? std::vector<int64_t>{-1} : args_;
+        const std::vector<int> threads = threads_.empty() ? std::vector<int>{1} : threads_;
+
+        for (int64_t arg : args) {
+            for (int thread_count : threads) {
+                run_one(arg, thread_count);
+            }
+        }
+    }
+
+private:
+    static constexpr std::chrono::milliseconds kMinTime{500};
+    static constexpr uint64_t kMaxIterations = 1000000000;
+
+    void run_one(int64_t arg, int thread_count) const {
+        std::string label = name_;
+        if (arg >= 0) {
+            label += "/" + std::to_string(arg);
+        }
+        if (thread_count > 1 || !threads_.empty()) {
+            label += "/threads:" + std::to_string(thread_count);
+        }
+
+        std::vector<int64_t> state_args;
+        if (arg >= 0) {
+            state_args.push_back(arg);
+        }
+
+        uint64_t iterations = 1;
+        for (;;) {
+            int64_t items = 0;
+            int64_t bytes = 0;
+            std::string error;
+            const double seconds = measure(iterations, state_args, thread_count, items, bytes, error);
+
+            if (!error.empty()) {
+                std::printf("%-48s ERROR: %s\n", label.c_str(), error.c_str());
+                return;
+            }
+
+            if (seconds >= std::chrono::duration<double>(kMinTime).count() || iterations >= kMaxIterations) {
+                // 与Google Benchmark的UseRealTime一致：墙钟时间除以所有线程的总迭代次数
+                const uint64_t total = iterations * static_cast<uint64_t>(thread_count);
+                const double ns_per_iteration = seconds * 1e9 / static_cast<double>(total);
+                std::printf("%-48s %14.1f ns %12llu", label.c_str(), ns_per_iteration,
+                            static_cast<unsigned long long>(total));
+                if (items > 0) {
+                    std::printf("  %10.3fM items/s", items / seconds / 1e6);
+                }
+                if (bytes > 0) {
+                    std::printf("  %10.1f MB/s", bytes / seconds / (1024.0 * 1024.0));
+                }
+                std::printf("\n");
+                return;
+            }
+
+            // 按本次耗时估算达到kMinTime所需的迭代次数，至多增长10倍
+            const double target = std::chrono::duration<double>(kMinTime).count() * 1.2;
+            const double scale = seconds > 0 ? std::min(10.0, target / seconds) : 10.0;
+            iterations = std::min<uint64_t>(kMaxIterations,
+                                            std::max<uint64_t>(iterations + 1,
+                                                               static_cast<uint64_t>(iterations * scale)));
+        }
+    }
+
+    double measure(uint64_t iterations, const std::vector<int64_t>& args, int thread_count,
+                   int64_t& items, int64_t& bytes, std::string& error) const {
+        std::vector<std::unique_ptr<State>> states;
+        for (int i = 0; i < thread_count; ++i) {
+            states.push_back(std::make_unique<State>(iterations, args, i, thread_count));
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (thread_count == 1) {
+            fn_(*states.front());
+        } else {
+            std::vector<std::thread> workers;
+            for (auto& state : states) {
+                workers.emplace_back([this, &state]() { fn_(*state); });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        items = 0;
+        bytes = 0;
+        for (const auto& state : states) {
+            items += state->items_processed();
+            bytes += state->bytes_processed();
+            if (!state->error().empty()) {
+                error = state->error();
+            }
+        }
+        return seconds;
+    }
+
+    std::string name_;
+    Function fn_;
+    std::vector<int64_t> args_;
+    std::vector<int> threads_;
+};
+
+inline std::vector<std::unique_ptr<Benchmark>>& registry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark* register_benchmark(const char* name, Function fn) {
+    registry().push_back(std::make_unique<Benchmark>(name, fn));
+    return registry().back().get();
+}
+
+inline int run_all() {
+    std::printf("%-48s %17s %12s\n", "Benchmark", "Time", "Iterations");
+    for (const auto& benchmark : registry()) {
+        benchmark->run();
+    }
+    return 0;
+}
+
+} // namespace internal
+} // namespace benchmark
+
+#define WS_MINI_BENCHMARK_CONCAT_(a, b) a##b
+#define WS_MINI_BENCHMARK_CONCAT(a, b) WS_MINI_BENCHMARK_CONCAT_(a, b)
+
+#define BENCHMARK(fn)                                                          \
+    static ::benchmark::internal::Benchmark* WS_MINI_BENCHMARK_CONCAT(         \
+        ws_mini_benchmark_, __LINE__) = ::benchmark::internal::register_benchmark(#fn, fn)
+
+#define BENCHMARK_MAIN()                                                       \
+    int main() { return ::benchmark::internal::run_all(); }
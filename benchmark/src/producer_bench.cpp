@@ -0,0 +1,125 @@
+// 多生产者发送：同一个客户端上不同生产者线程数的发送吞吐
+//
+// 用法: producer_bench [最大线程数=8] [消息字节=64] [秒数=3] [端口=9140]
+// 生产者线程数按1,2,4...翻倍直到最大值。每个生产者循环调用send_text(std::move)，
+// 在途消息（已发送未送达）超过上限时让出CPU，避免无界队列无限增长。
+// 送达数以服务器消息回调计数为准。
+
+#include "bench_common.hpp"
+#include "ws_server/server.hpp"
+#include "ws_client/client.hpp"
+#include <algorithm>
+#include <cstdio>
+
+using namespace KK_WS;
+
+namespace {
+
+constexpr uint64_t kMaxInFlight = 100000;
+
+struct ProducerResult {
+    uint64_t sent = 0;
+    uint64_t delivered = 0;
+    double seconds = 0.0;
+    double cpu_seconds = 0.0;
+};
+
+ProducerResult run(size_t producers, size_t message_size, size_t seconds, uint16_t port) {
+    std::atomic<uint64_t> delivered{0};
+
+    server::ServerConfig server_config;
+    server_config.port = port;
+    server_config.enable_logging = false;
+    server_config.io_threads = 1;
+
+    server::WebSocketServer srv(server_config);
+    srv.set_message_handler([&delivered](server::connection_hdl, const std::string&) {
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    });
+    std::thread server_thread([&srv]() { srv.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    client::ClientConfig client_config;
+    client_config.server_uri = "ws://127.0.0.1:" + std::to_string(port);
+    client_config.auto_reconnect = false;
+    client_config.ping_interval_ms = 0;
+
+    ProducerResult result;
+    {
+        client::WebSocketClient client("producer-bench");
+        if (!client.connect(client_config)) {
+            std::printf("  连接失败: %s\n", client_config.server_uri.c_str());
+        } else {
+            std::atomic<bool> running{true};
+            std::atomic<uint64_t> sent{0};
+            const std::string payload(message_size, 'x');
+
+            auto cpu_start = bench::process_cpu_seconds();
+            auto start = std::chrono::steady_clock::now();
+
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < producers; ++i) {
+                threads.emplace_back([&]() {
+                    while (running.load(std::memory_order_relaxed)) {
+                        if (sent.load(std::memory_order_relaxed) -
+                                delivered.load(std::memory_order_relaxed) > kMaxInFlight) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        std::string message = payload;
+                        client.send_text(std::move(message));
+                        sent.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+            }
+
+            std::this_thread::sleep_for(std::chrono::seconds(seconds));
+            running = false;
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            // 等待在途消息送达
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (delivered < sent && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            result.sent = sent;
+            result.delivered = delivered;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.cpu_seconds = bench::process_cpu_seconds() - cpu_start;
+
+            client.disconnect();
+        }
+    }
+
+    srv.stop();
+    server_thread.join();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::set_level(Logger::Level::Ws_WARNING);
+
+    const size_t max_producers = std::max<size_t>(1, bench::arg_or(argc, argv, 1, 8));
+    const size_t message_size = std::max<size_t>(1, bench::arg_or(argc, argv, 2, 64));
+    const size_t seconds = bench::arg_or(argc, argv, 3, 3);
+    const auto port = static_cast<uint16_t>(bench::arg_or(argc, argv, 4, 9140));
+
+    std::printf("消息大小: %zu 字节, 每项 %zu 秒\n", message_size, seconds);
+    std::printf("%-10s %14s %14s %16s\n", "生产者", "发送/s", "送达/s", "CPU(us/消息)");
+
+    uint16_t next_port = port;
+    for (size_t producers = 1; producers <= max_producers; producers *= 2) {
+        auto r = run(producers, message_size, seconds, next_port++);
+        const double cpu_us = r.delivered ? r.cpu_seconds * 1e6 / r.delivered : 0.0;
+        std::printf("%-10zu %14.0f %14.0f %16.2f\n", producers,
+                    r.seconds > 0 ? r.sent / r.seconds : 0.0,
+                    r.seconds > 0 ? r.delivered / r.seconds : 0.0,
+                    cpu_us);
+    }
+    return 0;
+}
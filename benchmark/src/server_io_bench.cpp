@@ -0,0 +1,66 @@
+// 服务器I/O模型对比：共享io_service vs SO_REUSEPORT分片
+//
+// 用法: server_io_bench [连接数=200] [线程数=4] [秒数=5] [端口=9100]
+
+#include "bench_common.hpp"
+#include "ws_server/server.hpp"
+#include <cstdio>
+
+using namespace KK_WS;
+
+namespace {
+
+bench::LoadResult run_mode(server::IoModel model, size_t threads, size_t connections,
+                           std::chrono::seconds duration, uint16_t port) {
+    server::ServerConfig config;
+    config.port = port;
+    config.enable_logging = false;
+    config.io_model = model;
+    config.io_threads = threads;
+
+    server::WebSocketServer srv(config);
+    std::thread server_thread([&srv]() { srv.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    bench::LoadResult result;
+    {
+        bench::EchoLoad load(threads, std::string(64, 'x'));
+        size_t opened = load.open("ws://127.0.0.1:" + std::to_string(port), connections);
+        if (opened != connections) {
+            std::printf("  警告: 仅建立了 %zu/%zu 个连接\n", opened, connections);
+        }
+        result = load.run(duration);
+    }
+
+    srv.stop();
+    server_thread.join();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::set_level(Logger::Level::Ws_WARNING);
+
+    const size_t connections = bench::arg_or(argc, argv, 1, 200);
+    const size_t threads = bench::arg_or(argc, argv, 2, 4);
+    const auto duration = std::chrono::seconds(bench::arg_or(argc, argv, 3, 5));
+    const auto port = static_cast<uint16_t>(bench::arg_or(argc, argv, 4, 9100));
+
+    std::printf("连接数: %zu, 服务器线程: %zu, 时长: %llds\n",
+                connections, threads, static_cast<long long>(duration.count()));
+
+    auto shared = run_mode(server::IoModel::SharedIoService, threads, connections, duration, port);
+    std::printf("共享io_service    : %12.0f msg/s  (CPU %.2fs)\n",
+                shared.msgs_per_sec(), shared.cpu_seconds);
+
+    auto sharded = run_mode(server::IoModel::ShardedReusePort, threads, connections, duration,
+                            static_cast<uint16_t>(port + 1));
+    std::printf("SO_REUSEPORT分片  : %12.0f msg/s  (CPU %.2fs)\n",
+                sharded.msgs_per_sec(), sharded.cpu_seconds);
+
+    if (shared.msgs_per_sec() > 0) {
+        std::printf("分片/共享 吞吐比  : %.2fx\n", sharded.msgs_per_sec() / shared.msgs_per_sec());
+    }
+    return 0;
+}
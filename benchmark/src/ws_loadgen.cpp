@@ -0,0 +1,413 @@
+// ws_loadgen：多连接回显负载生成器
+//
+// 用法: ws_loadgen [选项]
+//   --uri=ws://127.0.0.1:9002   目标服务器
+//   --connections=1             连接数
+//   --rate=0                    所有连接合计的目标发送速率（消息/秒），0表示不限速
+//   --size=1024                 消息负载字节数（不含延迟信封）
+//   --binary-ratio=0            二进制消息所占比例 0~1，其余为文本消息
+//   --duration=10               测量时长（秒）
+//   --warmup=1                  预热时长（秒），不计入结果
+//   --senders=0                 发送线程数，0表示 min(连接数, CPU核数)
+//   --max-inflight=1000         每个连接已发送未收到回显的消息上限，超过时暂停该连接的发送
+//   --format=text|json          输出格式
+//
+// 每条消息带延迟信封（ClientConfig::latency_envelope），服务器回复时需带回信封才能
+// 统计往返延迟。WebSocketServer的内置回显/转发原样带回；消息处理回调看到的是
+// 去掉信封的负载，回调中回复发送方时服务器重新附加，参考服务器main.cpp的
+// "Echo: " 回复同样可以统计。
+
+#include "bench_common.hpp"
+#include "ws_client/client.hpp"
+#include "ws_common/latency_envelope.hpp"
+#include "ws_common/metrics.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+using namespace KK_WS;
+
+namespace {
+
+// core::Connection记录往返延迟的进程级直方图（纳秒），见ClientMetrics
+constexpr char kRoundTripMetric[] = "ws_client_round_trip_latency_seconds";
+
+struct Options {
+    std::string uri = "ws://127.0.0.1:9002";
+    size_t connections = 1;
+    double rate = 0.0;
+    size_t size = 1024;
+    double binary_ratio = 0.0;
+    double duration = 10.0;
+    double warmup = 1.0;
+    size_t senders = 0;
+    uint64_t max_inflight = 1000;
+    bool json = false;
+};
+
+void print_usage() {
+    std::printf("用法: ws_loadgen [--uri=URI] [--connections=N] [--rate=MSG_PER_SEC] [--size=BYTES]\n"
+                "                  [--binary-ratio=0~1] [--duration=SEC] [--warmup=SEC] [--senders=N]\n"
+                "                  [--max-inflight=N] [--format=text|json]\n");
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+
+        const size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+            std::fprintf(stderr, "无法识别的参数: %s\n", arg.c_str());
+            return false;
+        }
+        const std::string key = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+
+        try {
+            if (key == "uri") {
+                options.uri = value;
+            } else if (key == "connections") {
+                options.connections = std::max<size_t>(1, std::stoul(value));
+            } else if (key == "rate") {
+                options.rate = std::max(0.0, std::stod(value));
+            } else if (key == "size") {
+                options.size = std::stoul(value);
+            } else if (key == "binary-ratio") {
+                options.binary_ratio = std::clamp(std::stod(value), 0.0, 1.0);
+            } else if (key == "duration") {
+                options.duration = std::max(0.1, std::stod(value));
+            } else if (key == "warmup") {
+                options.warmup = std::max(0.0, std::stod(value));
+            } else if (key == "senders") {
+                options.senders = std::stoul(value);
+            } else if (key == "max-inflight") {
+                options.max_inflight = std::max<uint64_t>(1, std::stoull(value));
+            } else if (key == "format") {
+                if (value != "text" && value != "json") {
+                    std::fprintf(stderr, "未知的输出格式: %s\n", value.c_str());
+                    return false;
+                }
+                options.json = value == "json";
+            } else {
+                std::fprintf(stderr, "未知的选项: --%s\n", key.c_str());
+                return false;
+            }
+        } catch (...) {
+            std::fprintf(stderr, "无效的参数值: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 一个压测连接及其计数
+ */
+struct LoadConnection {
+    std::shared_ptr<client::WebSocketClient> client;
+    std::string id;
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> received_bytes{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+struct Totals {
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t received_bytes = 0;
+    uint64_t errors = 0;
+};
+
+Totals sum(const std::vector<std::unique_ptr<LoadConnection>>& connections) {
+    Totals totals;
+    for (const auto& c : connections) {
+        totals.sent += c->sent.load(std::memory_order_relaxed);
+        totals.received += c->received.load(std::memory_order_relaxed);
+        totals.received_bytes += c->received_bytes.load(std::memory_order_relaxed);
+        totals.errors += c->errors.load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+/**
+ * @brief 一次压测的结果
+ */
+struct Report {
+    size_t connections_requested = 0;
+    size_t connections_established = 0;
+    double seconds = 0.0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t received_bytes = 0;
+    uint64_t send_failures = 0;
+    uint64_t connection_errors = 0;
+    uint64_t lost = 0;              // 结束时仍未收到回显的消息数
+    HistogramSnapshot latency;      // 往返延迟（纳秒）
+};
+
+void print_text(const Options& options, const Report& r) {
+    const double msgs_per_sec = r.seconds > 0 ? r.received / r.seconds : 0.0;
+    const double mb_per_sec = r.seconds > 0 ? r.received_bytes / r.seconds / (1024.0 * 1024.0) : 0.0;
+
+    std::printf("目标: %s\n", options.uri.c_str());
+    std::printf("连接: %zu/%zu  消息: %zu 字节  二进制比例: %.2f  目标速率: %s\n",
+                r.connections_established, r.connections_requested, options.size, options.binary_ratio,
+                options.rate > 0 ? std::to_string(static_cast<uint64_t>(options.rate)).c_str() : "不限");
+    std::printf("时长: %.2f 秒\n", r.seconds);
+    std::printf("发送: %llu  (%.0f msg/s)\n", static_cast<unsigned long long>(r.sent),
+                r.seconds > 0 ? r.sent / r.seconds : 0.0);
+    std::printf("回显: %llu  (%.0f msg/s, %.2f MB/s)\n", static_cast<unsigned long long>(r.received),
+                msgs_per_sec, mb_per_sec);
+
+    if (r.latency.count > 0) {
+        std::printf("往返延迟(us): p50 %.1f  p99 %.1f  p999 %.1f  max %.1f  mean %.1f  (样本 %llu)\n",
+                    r.latency.p50 / 1e3, r.latency.p99 / 1e3, r.latency.p999 / 1e3,
+                    r.latency.max / 1e3, r.latency.mean / 1e3,
+                    static_cast<unsigned long long>(r.latency.count));
+    } else {
+        std::printf("往返延迟: 无样本（服务器未原样回显消息）\n");
+    }
+
+    std::printf("错误: 连接失败 %zu  发送失败 %llu  连接错误 %llu  未回显 %llu\n",
+                r.connections_requested - r.connections_established,
+                static_cast<unsigned long long>(r.send_failures),
+                static_cast<unsigned long long>(r.connection_errors),
+                static_cast<unsigned long long>(r.lost));
+}
+
+void print_json(const Options& options, const Report& r) {
+    const double msgs_per_sec = r.seconds > 0 ? r.received / r.seconds : 0.0;
+    const double bytes_per_sec = r.seconds > 0 ? r.received_bytes / r.seconds : 0.0;
+
+    std::printf("{\n");
+    std::printf("  \"uri\": \"%s\",\n", options.uri.c_str());
+    std::printf("  \"connections\": {\"requested\": %zu, \"established\": %zu},\n",
+                r.connections_requested, r.connections_established);
+    std::printf("  \"message_size\": %zu,\n", options.size);
+    std::printf("  \"binary_ratio\": %.3f,\n", options.binary_ratio);
+    std::printf("  \"target_rate\": %.0f,\n", options.rate);
+    std::printf("  \"duration_seconds\": %.3f,\n", r.seconds);
+    std::printf("  \"sent\": %llu,\n", static_cast<unsigned long long>(r.sent));
+    std::printf("  \"received\": %llu,\n", static_cast<unsigned long long>(r.received));
+    std::printf("  \"throughput\": {\"messages_per_second\": %.1f, \"bytes_per_second\": %.1f},\n",
+                msgs_per_sec, bytes_per_sec);
+    std::printf("  \"latency_us\": {\"samples\": %llu, \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, "
+                "\"max\": %.1f, \"mean\": %.1f},\n",
+                static_cast<unsigned long long>(r.latency.count),
+                r.latency.p50 / 1e3, r.latency.p99 / 1e3, r.latency.p999 / 1e3,
+                r.latency.max / 1e3, r.latency.mean / 1e3);
+    std::printf("  \"errors\": {\"connect\": %zu, \"send\": %llu, \"connection\": %llu, \"lost\": %llu}\n",
+                r.connections_requested - r.connections_established,
+                static_cast<unsigned long long>(r.send_failures),
+                static_cast<unsigned long long>(r.connection_errors),
+                static_cast<unsigned long long>(r.lost));
+    std::printf("}\n");
+}
+
+/**
+ * @brief 发送线程：轮流向自己负责的连接发送，按目标速率均匀排布发送时刻
+ *
+ * 落后于计划时连续发送追赶，不补发超过一秒的欠账，避免停顿后突发。
+ */
+void sender_loop(const Options& options, std::vector<LoadConnection*> targets, double rate,
+                 const std::atomic<bool>& running, std::atomic<uint64_t>& send_failures) {
+    if (targets.empty()) {
+        return;
+    }
+
+    const std::string text(options.size, 'x');
+    const auto binary_permille = static_cast<uint64_t>(options.binary_ratio * 1000.0 + 0.5);
+
+    using clock = std::chrono::steady_clock;
+    const auto interval = rate > 0 ? std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / rate)) : clock::duration::zero();
+    auto next = clock::now();
+
+    uint64_t sequence = 0;
+    size_t index = 0;
+    size_t blocked = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        LoadConnection& target = *targets[index];
+        index = (index + 1) % targets.size();
+
+        // 在途消息过多时跳过该连接；所有连接都阻塞时让出CPU
+        if (target.sent.load(std::memory_order_relaxed) - target.received.load(std::memory_order_relaxed)
+                >= options.max_inflight) {
+            if (++blocked >= targets.size()) {
+                blocked = 0;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            continue;
+        }
+        blocked = 0;
+
+        if (rate > 0) {
+            const auto now = clock::now();
+            if (now < next) {
+                std::this_thread::sleep_until(next);
+            } else if (now - next > std::chrono::seconds(1)) {
+                next = now;
+            }
+            next += interval;
+        }
+
+        // 按比例确定性地交替文本和二进制消息
+        const bool binary = (sequence + 1) * binary_permille / 1000 != sequence * binary_permille / 1000;
+        ++sequence;
+
+        // 预留信封的空间，发送路径插入信封时不再重新分配
+        std::string payload;
+        payload.reserve(text.size() + latency_envelope::kSize);
+        payload = text;
+
+        const auto type = binary ? ws_message::message_type::BINARY : ws_message::message_type::TEXT;
+        if (target.client->send_message(ws_message(type, std::move(payload)))) {
+            target.sent.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            send_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 2;
+    }
+
+    Logger::set_level(Logger::Level::Ws_WARNING);
+    bench::raise_fd_limit();
+
+    client::ClientConfig config;
+    config.server_uri = options.uri;
+    config.auto_reconnect = false;
+    config.ping_interval_ms = 0;
+    config.latency_envelope = true;
+
+    // 建立连接：所有连接同时发起，等待全部完成或超时
+    auto& manager = client::ClientManager::instance();
+    std::vector<std::unique_ptr<LoadConnection>> connections;
+    std::atomic<size_t> connected{0};
+    std::atomic<size_t> finished{0};
+
+    for (size_t i = 0; i < options.connections; ++i) {
+        auto c = std::make_unique<LoadConnection>();
+        c->id = "loadgen_" + std::to_string(i);
+        c->client = manager.create_client(c->id);
+        if (!c->client) {
+            finished++;
+            continue;
+        }
+
+        LoadConnection* raw = c.get();
+        c->client->set_message_callback([raw](const ws_message_view& msg) {
+            raw->received.fetch_add(1, std::memory_order_relaxed);
+            raw->received_bytes.fetch_add(msg.payload.size(), std::memory_order_relaxed);
+        });
+        c->client->set_error_callback([raw](const std::string&) {
+            raw->errors.fetch_add(1, std::memory_order_relaxed);
+        });
+        c->client->async_connect(config, [&connected, &finished](bool success, const std::string&) {
+            if (success) {
+                connected++;
+            }
+            finished++;
+        });
+        connections.push_back(std::move(c));
+    }
+
+    const auto connect_deadline = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(config.connect_timeout_ms) + std::chrono::seconds(5);
+    while (finished < options.connections && std::chrono::steady_clock::now() < connect_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::vector<LoadConnection*> established;
+    for (auto& c : connections) {
+        if (c->client->is_connected()) {
+            established.push_back(c.get());
+        }
+    }
+    if (established.empty()) {
+        std::fprintf(stderr, "没有建立任何连接: %s\n", options.uri.c_str());
+        return 1;
+    }
+
+    // 发送线程各自负责一部分连接，目标速率平均分配
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const size_t sender_count = std::min(established.size(),
+                                         options.senders > 0 ? options.senders : cores);
+    std::vector<std::vector<LoadConnection*>> assignments(sender_count);
+    for (size_t i = 0; i < established.size(); ++i) {
+        assignments[i % sender_count].push_back(established[i]);
+    }
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> send_failures{0};
+    std::vector<std::thread> senders;
+    for (auto& targets : assignments) {
+        senders.emplace_back(sender_loop, std::cref(options), targets,
+                             options.rate / static_cast<double>(sender_count),
+                             std::cref(running), std::ref(send_failures));
+    }
+
+    // 预热结束后清零延迟直方图并记录计数基线
+    Histogram& latency = MetricsRegistry::global().histogram(kRoundTripMetric, "", 1e-9);
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmup));
+    latency.reset();
+    const Totals baseline = sum(connections);
+    const uint64_t failures_baseline = send_failures.load();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+
+    const Totals measured = sum(connections);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const HistogramSnapshot latency_snapshot = latency.snapshot();
+
+    running = false;
+    for (auto& t : senders) {
+        t.join();
+    }
+
+    // 等待在途消息回显，剩余的计为未回显
+    const auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    Totals final_totals = sum(connections);
+    while (final_totals.received < final_totals.sent && std::chrono::steady_clock::now() < drain_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        final_totals = sum(connections);
+    }
+
+    Report report;
+    report.connections_requested = options.connections;
+    report.connections_established = established.size();
+    report.seconds = seconds;
+    report.sent = measured.sent - baseline.sent;
+    report.received = measured.received - baseline.received;
+    report.received_bytes = measured.received_bytes - baseline.received_bytes;
+    report.send_failures = send_failures.load() - failures_baseline;
+    report.connection_errors = final_totals.errors;
+    report.lost = final_totals.sent - std::min(final_totals.sent, final_totals.received);
+    report.latency = latency_snapshot;
+
+    for (auto& c : connections) {
+        if (c->client) {
+            manager.remove_client(c->id);
+        }
+    }
+
+    if (options.json) {
+        print_json(options, report);
+    } else {
+        print_text(options, report);
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 
 #include "ws_client/client_config.hpp"
 #include "ws_common/interface.hpp"
+#include "ws_common/histogram.hpp"
 #include <memory>
 #include <string>
 #include <functional>
@@ -9,6 +10,10 @@
 #include <map>
 #include <mutex>
 
+namespace KK_WS::core {
+class IoPool;
+}
+
 namespace KK_WS::client {
 
 // 前向声明
@@ -24,8 +29,10 @@ public:
     /**
      * @brief 构造函数
      * @param client_id 客户端标识（可选）
+     * @param io_pool 共享的事件循环池（可选），为空时独占一个IO线程
      */
-    explicit WebSocketClient(const std::string& client_id = "");
+    explicit WebSocketClient(const std::string& client_id = "",
+                             std::shared_ptr<core::IoPool> io_pool = nullptr);
 
     /**
      * @brief 析构函数
@@ -49,12 +56,22 @@ public:
     bool connect(const ws_config& config) override;
 
     /**
-     * @brief 使用客户端配置连接
+     * @brief 使用客户端配置连接（阻塞等待async_connect的结果）
+     *
+     * 在IO线程的回调中调用时不会等待（等待会阻塞握手本身）：只发起连接并立即
+     * 返回false，回调中应改用async_connect。
      * @param config 客户端配置
      * @return 连接是否成功
      */
     bool connect(const ClientConfig& config);
 
+    /**
+     * @brief 异步连接，握手完成、失败或超时（connect_timeout_ms）时回调
+     * @param callback 在IO线程上调用
+     */
+    void async_connect(const ws_config& config, ConnectCallback callback) override;
+    void async_connect(const ClientConfig& config, ConnectCallback callback);
+
     /**
      * @brief 断开连接
      */
@@ -71,21 +88,53 @@ public:
      */
     bool send_message(const ws_message& message) override;
 
+    /**
+     * @brief 发送消息，负载缓冲区直接移交给发送帧，不再拷贝
+     */
+    bool send_message(ws_message&& message) override;
+
+    /**
+     * @brief 发送共享缓冲区中的负载（同一份负载发给多个客户端时使用）
+     *
+     * 客户端帧需要加掩码，负载会被拷贝一次到发送帧中，缓冲区本身不被修改。
+     */
+    bool send_message(ws_message::message_type type,
+                      std::shared_ptr<const std::string> payload) override;
+
+    /**
+     * @brief 批量发送一组消息
+     *
+     * 只获取一次锁、检查一次状态，所有消息编码进同一块缓冲区后交给socket
+     * 一次写出，适合突发的大量小消息。批内顺序与vector顺序一致。
+     * @return 任一消息发送失败时返回false
+     */
+    bool send_batch(std::vector<ws_message>&& messages);
+
     /**
      * @brief 发送文本消息（便捷方法）
-     * @param text 文本内容
+     * @param text 文本内容，传入右值时不拷贝
      */
     void send_text(const std::string& text);
+    void send_text(std::string&& text);
 
     /**
      * @brief 发送二进制消息（便捷方法）
-     * @param data 二进制数据
+     * @param data 二进制数据，传入右值时不拷贝
      */
     void send_binary(const std::string& data);
+    void send_binary(std::string&& data);
 
     // ========== 回调设置 ==========
 
     void set_message_callback(MessageCallback callback) override;
+
+    /**
+     * @brief 设置零拷贝消息回调
+     *
+     * 视图直接引用接收缓冲区；回调返回后仍需使用负载时，保存ws_message_view
+     * 本身（持有缓冲区引用）即可，无需拷贝。可与拷贝版回调同时设置。
+     */
+    void set_message_callback(MessageViewCallback callback) override;
     void set_state_callback(StateCallback callback) override;
     void set_error_callback(ErrorCallback callback) override;
 
@@ -140,6 +189,24 @@ public:
      */
     uint64_t get_messages_received() const;
 
+    /**
+     * @brief 获取心跳往返时间统计（微秒）
+     *
+     * 每个心跳间隔发送一次ping，收到对应pong时记录往返时间；
+     * 自动重连期间保留，重新调用connect()后从零开始。
+     */
+    HistogramSnapshot get_rtt_stats() const;
+
+    /**
+     * @brief 消息延迟统计（纳秒），需要在配置中启用latency_envelope
+     *
+     * 往返延迟：本客户端发出的消息被服务器原样回显后收到的时间；
+     * 单向延迟：对端带信封发出的消息到达本客户端的时间，只有两端在同一主机上时才有意义。
+     * 与get_rtt_stats()一样，重新调用connect()后从零开始。
+     */
+    HistogramSnapshot get_round_trip_latency_stats() const;
+    HistogramSnapshot get_one_way_latency_stats() const;
+
     /**
      * @brief 检查是否已连接
      */
@@ -154,7 +221,7 @@ private:
 /**
  * @brief 客户端管理器（单例）
  *
- * 用于管理多个WebSocket客户端实例
+ * 用于管理多个WebSocket客户端实例，所有客户端共享一个事件循环池
  */
 class ClientManager {
 public:
@@ -176,6 +243,8 @@ public:
 private:
     ClientManager() = default;
 
+    // 声明在clients_之前，保证所有客户端先于事件循环池析构
+    std::shared_ptr<core::IoPool> io_pool_;
     std::map<std::string, std::shared_ptr<WebSocketClient>> clients_;
     ClientConfig global_config_;
     mutable std::mutex mutex_;
@@ -1,4 +1,5 @@
 #pragma once
+#include "ws_common/interface.hpp"
 #include <string>
 #include <cstdint>
 
@@ -11,10 +12,15 @@ struct ClientConfig {
     std::string server_uri = "ws://localhost:9002";  // 服务器地址
     uint16_t server_port = 9002;                     // 服务器端口
     bool auto_reconnect = true;                      // 自动重连
-    uint32_t reconnect_interval_ms = 3000;           // 重连间隔
-    uint32_t ping_interval_ms = 10000;               // 心跳间隔
+    uint32_t reconnect_interval_ms = 3000;           // 重连退避的基础间隔
+    uint32_t reconnect_max_interval_ms = 60000;      // 重连退避的上限
+    int max_reconnect_attempts = 5;                  // 最大重连次数，0表示不限
+    uint32_t ping_interval_ms = 10000;               // 心跳间隔，0表示关闭心跳
+    uint32_t pong_timeout_ms = 5000;                 // 等待pong超时，超时即断开
     uint32_t connect_timeout_ms = 5000;              // 连接超时
     bool verbose_logging = false;                    // 详细日志
+    ws_compression_config compression;               // permessage-deflate压缩
+    bool latency_envelope = false;                   // 消息附加发送时间戳以统计延迟
 
     // 构建完整的WebSocket URI
     std::string get_full_uri() const {
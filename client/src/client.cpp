@@ -1,9 +1,10 @@
 #include "ws_client/client.hpp"
 #include "ws_core/connection.hpp"
+#include "ws_core/io_pool.hpp"
 #include "ws_common/logger.hpp"
-#include <thread>
 #include <chrono>
 #include <atomic>
+#include <future>
 #include <set>
 
 namespace KK_WS::client {
@@ -12,14 +13,15 @@ namespace KK_WS::client {
 
 class ClientImpl {
 public:
-    ClientImpl(const std::string& client_id)
+    ClientImpl(const std::string& client_id, std::shared_ptr<core::IoPool> io_pool)
         : client_id_(client_id.empty() ? generate_client_id() : client_id)
+        , io_pool_(std::move(io_pool))
         , reconnect_attempts_(0)
         , messages_sent_(0)
         , messages_received_(0)
         , connection_start_time_(0) {
 
-        Logger::debug("创建客户端: " + client_id_);
+        Logger::debugf("创建客户端: {}", client_id_);
     }
 
     ~ClientImpl() {
@@ -28,72 +30,47 @@ public:
 
     // 连接管理
     bool connect(const ClientConfig& config) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        ws_config ws_cfg;
+        std::shared_ptr<core::Connection> connection = prepare_connection(config, ws_cfg);
 
-        if (connection_) {
-            Logger::warning("客户端 " + client_id_ + " 已连接，先断开");
-            disconnect_internal();
+        // 不持有mutex_等待：连接过程中的回调可能调用subscribe()等需要mutex_的方法。
+        // 在事件循环线程上调用时Connection::connect()只发起连接并立即返回false，不会阻塞
+        Logger::info("客户端 " + client_id_ + " 正在连接: " + ws_cfg.uri);
+        if (!connection->connect(ws_cfg)) {
+            Logger::error("客户端 " + client_id_ + " 连接失败");
+            return false;
         }
+        return true;
+    }
 
-        // 保存配置
-        config_ = config;
+    bool connect(const ws_config& config) {
+        return connect(to_client_config(config));
+    }
 
-        // 创建底层连接
+    void async_connect(const ClientConfig& config, ConnectCallback callback) {
         ws_config ws_cfg;
-        ws_cfg.uri = config.get_full_uri();
-        ws_cfg.enable_auto_reconnect = config.auto_reconnect;
-        ws_cfg.ping_interval_ms = config.ping_interval_ms;
-        ws_cfg.reconnect_interval_ms = config.reconnect_interval_ms;
-
-        connection_ = core::create_connection(ws_cfg);
+        std::shared_ptr<core::Connection> connection = prepare_connection(config, ws_cfg);
 
-        // 设置回调
-        connection_->set_message_callback([this](const ws_message& msg) {
-            on_message_received(msg);
-        });
-
-        connection_->set_state_callback([this](ws_connection_state state) {
-            on_state_changed(state);
-        });
-
-        connection_->set_error_callback([this](const std::string& error) {
-            on_error_occurred(error);
-        });
-
-        // 发起连接
+        // 在mutex_之外发起：Connection::async_connect()会等待事件循环线程执行，
+        // 而该线程上的回调可能正在等待mutex_。结果总是在IO线程上回调
         Logger::info("客户端 " + client_id_ + " 正在连接: " + ws_cfg.uri);
-        connection_->connect(ws_cfg);
-
-        // 等待连接完成（带超时）
-        auto start = std::chrono::steady_clock::now();
-        while (connection_->get_connection_state() == ws_connection_state::WS_CONNECTING) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - start);
-
-            if (elapsed.count() > config.connect_timeout_ms) {
-                Logger::error("连接超时: " + client_id_);
-                return false;
+        connection->async_connect(ws_cfg, [this, callback = std::move(callback)](
+                                              bool success, const std::string& error) {
+            if (!success) {
+                Logger::error("客户端 " + client_id_ + " 连接失败: " + error);
             }
-        }
-
-        return connection_->get_connection_state() == ws_connection_state::WS_CONNECTED;
+            if (callback) {
+                callback(success, error);
+            }
+        });
     }
 
-    bool connect(const ws_config& config) {
-        ClientConfig client_cfg;
-        client_cfg.server_uri = config.uri;
-        client_cfg.server_port = config.port;
-        client_cfg.auto_reconnect = config.enable_auto_reconnect;
-        client_cfg.ping_interval_ms = config.ping_interval_ms;
-        client_cfg.reconnect_interval_ms = config.reconnect_interval_ms;
-
-        return connect(client_cfg);
+    void async_connect(const ws_config& config, ConnectCallback callback) {
+        async_connect(to_client_config(config), std::move(callback));
     }
 
     void disconnect() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        // 不持有mutex_：Connection::disconnect()会等待事件循环线程
         disconnect_internal();
     }
 
@@ -104,27 +81,56 @@ public:
     }
 
     // 消息发送
-    bool send_message(const ws_message& message) {
-        std::lock_guard<std::mutex> lock(mutex_);
-
-        if (!connection_ || connection_->get_connection_state() != ws_connection_state::WS_CONNECTED) {
+    // 不获取mutex_：连接的发送接口只把消息放入无锁队列，多个线程可以同时发送。
+    // 各重载只转发负载，拷贝与否由连接层的对应重载决定
+    template <typename... Args>
+    bool send_message(Args&&... args) {
+        auto connection = active_connection();
+        if (!connection) {
             Logger::warning("客户端未连接，无法发送消息");
             return false;
         }
 
-        connection_->send_message(message);
+        if (!connection->send_message(std::forward<Args>(args)...)) {
+            return false;
+        }
         messages_sent_++;
         return true;
     }
 
+    bool send_batch(std::vector<ws_message>&& messages) {
+        if (messages.empty()) {
+            return true;
+        }
+
+        auto connection = active_connection();
+        if (!connection) {
+            Logger::warning("客户端未连接，无法发送消息");
+            return false;
+        }
+
+        const size_t count = messages.size();
+        if (!connection->send_batch(std::move(messages))) {
+            return false;
+        }
+        messages_sent_ += count;
+        return true;
+    }
+
     void send_text(const std::string& text) {
-        ws_message msg(ws_message::message_type::TEXT, text, 0);
-        send_message(msg);
+        send_message(ws_message(ws_message::message_type::TEXT, text, 0));
+    }
+
+    void send_text(std::string&& text) {
+        send_message(ws_message(ws_message::message_type::TEXT, std::move(text), 0));
     }
 
     void send_binary(const std::string& data) {
-        ws_message msg(ws_message::message_type::BINARY, data, 0);
-        send_message(msg);
+        send_message(ws_message(ws_message::message_type::BINARY, data, 0));
+    }
+
+    void send_binary(std::string&& data) {
+        send_message(ws_message(ws_message::message_type::BINARY, std::move(data), 0));
     }
 
     // 回调设置
@@ -133,6 +139,11 @@ public:
         message_callback_ = std::move(callback);
     }
 
+    void set_message_view_callback(MessageViewCallback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        message_view_callback_ = std::move(callback);
+    }
+
     void set_state_callback(StateCallback callback) {
         std::lock_guard<std::mutex> lock(mutex_);
         state_callback_ = std::move(callback);
@@ -146,31 +157,33 @@ public:
     // 订阅管理
     void subscribe(const std::string& topic) {
         std::lock_guard<std::mutex> lock(mutex_);
-        subscriptions_.insert(topic);
-
-        // 发送订阅消息到服务器
-        if (connection_ && connection_->get_connection_state() == ws_connection_state::WS_CONNECTED) {
-            send_text("SUBSCRIBE:" + topic);
+        {
+            std::lock_guard<std::mutex> subscriptions_lock(subscriptions_mutex_);
+            subscriptions_.insert(topic);
         }
+
+        // 发送订阅消息到服务器（已持有mutex_，直接走send_message_locked）
+        send_message_locked(ws_message(ws_message::message_type::TEXT, "SUBSCRIBE:" + topic, 0));
     }
 
     void unsubscribe(const std::string& topic) {
         std::lock_guard<std::mutex> lock(mutex_);
-        subscriptions_.erase(topic);
+        {
+            std::lock_guard<std::mutex> subscriptions_lock(subscriptions_mutex_);
+            subscriptions_.erase(topic);
+        }
 
         // 发送取消订阅消息
-        if (connection_ && connection_->get_connection_state() == ws_connection_state::WS_CONNECTED) {
-            send_text("UNSUBSCRIBE:" + topic);
-        }
+        send_message_locked(ws_message(ws_message::message_type::TEXT, "UNSUBSCRIBE:" + topic, 0));
     }
 
     bool is_subscribed(const std::string& topic) const {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
         return subscriptions_.find(topic) != subscriptions_.end();
     }
 
     std::vector<std::string> get_subscriptions() const {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
         return {subscriptions_.begin(), subscriptions_.end()};
     }
 
@@ -200,41 +213,133 @@ public:
         return messages_received_;
     }
 
+    HistogramSnapshot get_rtt_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_ ? connection_->get_rtt_stats() : HistogramSnapshot{};
+    }
+
+    HistogramSnapshot get_round_trip_latency_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_ ? connection_->get_round_trip_latency_stats() : HistogramSnapshot{};
+    }
+
+    HistogramSnapshot get_one_way_latency_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_ ? connection_->get_one_way_latency_stats() : HistogramSnapshot{};
+    }
+
 private:
+    // 已连接时返回当前连接，否则返回空；不需要持有mutex_
+    std::shared_ptr<core::Connection> active_connection() const {
+        auto connection = std::atomic_load(&connection_);
+        if (!connection || connection->get_connection_state() != ws_connection_state::WS_CONNECTED) {
+            return nullptr;
+        }
+        return connection;
+    }
+
+    // 调用方需持有mutex_
+    template <typename... Args>
+    bool send_message_locked(Args&&... args) {
+        if (!connection_ || connection_->get_connection_state() != ws_connection_state::WS_CONNECTED) {
+            return false;
+        }
+
+        connection_->send_message(std::forward<Args>(args)...);
+        messages_sent_++;
+        return true;
+    }
+
+    /**
+     * @brief 断开旧连接，在mutex_下创建并发布新连接（尚未发起连接）
+     * @param ws_cfg 输出：由config转换得到的底层连接配置
+     */
+    std::shared_ptr<core::Connection> prepare_connection(const ClientConfig& config, ws_config& ws_cfg) {
+        // 旧连接的断开会等待事件循环线程，在获取mutex_之前完成
+        if (std::atomic_load(&connection_)) {
+            Logger::warning("客户端 " + client_id_ + " 已连接，先断开");
+            disconnect_internal();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // 保存配置
+        config_ = config;
+
+        // 创建底层连接
+        ws_cfg.uri = config.get_full_uri();
+        ws_cfg.enable_auto_reconnect = config.auto_reconnect;
+        ws_cfg.ping_interval_ms = config.ping_interval_ms;
+        ws_cfg.pong_timeout_ms = config.pong_timeout_ms;
+        ws_cfg.reconnect_interval_ms = config.reconnect_interval_ms;
+        ws_cfg.reconnect_max_interval_ms = config.reconnect_max_interval_ms;
+        ws_cfg.max_reconnect_attempts = config.max_reconnect_attempts;
+        ws_cfg.connect_timeout_ms = static_cast<int>(config.connect_timeout_ms);
+        ws_cfg.compression = config.compression;
+        ws_cfg.latency_envelope = config.latency_envelope;
+
+        // 发送路径不持有mutex_，通过原子读取获取连接
+        std::shared_ptr<core::Connection> connection = core::create_connection(ws_cfg, io_pool_);
+
+        // 设置回调
+        connection->set_message_callback([this](const ws_message_view& msg) {
+            on_message_received(msg);
+        });
+
+        // 回调由该连接自身发出，期间连接一定存活，可以直接使用裸指针
+        IWebSocketEndpoint* endpoint = connection.get();
+        connection->set_state_callback([this, endpoint](ws_connection_state state) {
+            on_state_changed(state, *endpoint);
+        });
+
+        connection->set_error_callback([this](const std::string& error) {
+            on_error_occurred(error);
+        });
+
+        // 回调设置完成后再发布，其他线程不会看到缺少回调的连接
+        std::atomic_store(&connection_, connection);
+        return connection;
+    }
+
+    // 不需要mutex_：连接通过原子交换摘下，调用者不能持有mutex_
     void disconnect_internal() {
-        if (connection_) {
-            connection_->disconnect();
-            connection_.reset();
+        // 先摘下连接，之后的发送直接失败；正在发送的线程持有的引用在其返回后释放
+        auto connection = std::atomic_exchange(&connection_, std::shared_ptr<core::Connection>());
+        if (connection) {
+            connection->disconnect();
         }
         connection_start_time_ = 0;
     }
 
-    void on_message_received(const ws_message& msg) {
+    void on_message_received(const ws_message_view& msg) {
         messages_received_++;
 
-        // 调用用户回调
+        // 调用用户回调，只有设置了拷贝版回调时才拷贝负载
+        if (message_view_callback_) {
+            message_view_callback_(msg);
+        }
         if (message_callback_) {
-            message_callback_(msg);
+            message_callback_(msg.to_message());
         }
 
         // 记录日志
         if (config_.verbose_logging) {
-            std::string log_msg = "客户端 " + client_id_ + " 收到消息: ";
             if (msg.type == ws_message::message_type::TEXT) {
-                log_msg += msg.payload.substr(0, 50);
-                if (msg.payload.size() > 50) log_msg += "...";
+                Logger::debugf("客户端 {} 收到消息: {}", client_id_, Logger::preview(msg.payload, 50));
             } else {
-                log_msg += "[二进制数据 " + std::to_string(msg.payload.size()) + " 字节]";
+                Logger::debugf("客户端 {} 收到消息: [二进制数据 {} 字节]", client_id_, msg.payload.size());
             }
-            Logger::debug(log_msg);
         }
     }
 
-    void on_state_changed(ws_connection_state state) {
+    void on_state_changed(ws_connection_state state, IWebSocketEndpoint& connection) {
         // 更新连接开始时间
         if (state == ws_connection_state::WS_CONNECTED) {
             connection_start_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(
                                          std::chrono::system_clock::now().time_since_epoch()).count();
+
+            // 首次连接或自动重连成功后恢复订阅
+            replay_subscriptions(connection);
         } else if (state == ws_connection_state::WS_DISCONNECTED) {
             connection_start_time_ = 0;
         }
@@ -244,7 +349,30 @@ private:
             state_callback_(state);
         }
 
-        Logger::info("客户端 " + client_id_ + " 状态变更: " + state_to_string(state));
+        Logger::infof("客户端 {} 状态变更: {}", client_id_, state_to_string(state));
+    }
+
+    /**
+     * @brief 将全部订阅合并为一条 "SUBSCRIBE:a\nb\nc" 消息重新发送
+     *
+     * 在IO线程上调用，不获取mutex_（其他线程可能持有mutex_等待本连接关闭）。
+     */
+    void replay_subscriptions(IWebSocketEndpoint& connection) {
+        std::string batch;
+        {
+            std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+            if (subscriptions_.empty()) {
+                return;
+            }
+            for (const auto& topic : subscriptions_) {
+                batch += batch.empty() ? "SUBSCRIBE:" : "\n";
+                batch += topic;
+            }
+        }
+
+        if (connection.send_message(ws_message(ws_message::message_type::TEXT, std::move(batch), 0))) {
+            messages_sent_++;
+        }
     }
 
     void on_error_occurred(const std::string& error) {
@@ -255,6 +383,22 @@ private:
         Logger::error("客户端 " + client_id_ + " 错误: " + error);
     }
 
+    static ClientConfig to_client_config(const ws_config& config) {
+        ClientConfig client_cfg;
+        client_cfg.server_uri = config.uri;
+        client_cfg.server_port = config.port;
+        client_cfg.auto_reconnect = config.enable_auto_reconnect;
+        client_cfg.ping_interval_ms = config.ping_interval_ms;
+        client_cfg.pong_timeout_ms = config.pong_timeout_ms;
+        client_cfg.reconnect_interval_ms = config.reconnect_interval_ms;
+        client_cfg.reconnect_max_interval_ms = config.reconnect_max_interval_ms;
+        client_cfg.max_reconnect_attempts = config.max_reconnect_attempts;
+        client_cfg.connect_timeout_ms = static_cast<uint32_t>(config.connect_timeout_ms);
+        client_cfg.compression = config.compression;
+        client_cfg.latency_envelope = config.latency_envelope;
+        return client_cfg;
+    }
+
     static std::string generate_client_id() {
         static std::atomic<int> counter{0};
         return "client_" + std::to_string(++counter);
@@ -274,12 +418,15 @@ private:
 private:
     mutable std::mutex mutex_;
     std::string client_id_;
+    std::shared_ptr<core::IoPool> io_pool_;
     ClientConfig config_;
-    std::unique_ptr<IWebSocketEndpoint> connection_;
+    std::shared_ptr<core::Connection> connection_;  // 写入在mutex_下，并通过std::atomic_store发布
+    mutable std::mutex subscriptions_mutex_;  // 锁顺序：mutex_ → subscriptions_mutex_
     std::set<std::string> subscriptions_;
 
     // 回调
     MessageCallback message_callback_;
+    MessageViewCallback message_view_callback_;
     StateCallback state_callback_;
     ErrorCallback error_callback_;
 
@@ -292,8 +439,8 @@ private:
 
 // ========== WebSocketClient 公共接口实现 ==========
 
-WebSocketClient::WebSocketClient(const std::string& client_id)
-    : impl_(std::make_unique<ClientImpl>(client_id)) {
+WebSocketClient::WebSocketClient(const std::string& client_id, std::shared_ptr<core::IoPool> io_pool)
+    : impl_(std::make_unique<ClientImpl>(client_id, std::move(io_pool))) {
 }
 
 WebSocketClient::~WebSocketClient() = default;
@@ -309,6 +456,14 @@ bool WebSocketClient::connect(const ClientConfig& config) {
     return impl_->connect(config);
 }
 
+void WebSocketClient::async_connect(const ws_config& config, ConnectCallback callback) {
+    impl_->async_connect(config, std::move(callback));
+}
+
+void WebSocketClient::async_connect(const ClientConfig& config, ConnectCallback callback) {
+    impl_->async_connect(config, std::move(callback));
+}
+
 void WebSocketClient::disconnect() {
     impl_->disconnect();
 }
@@ -321,18 +476,42 @@ bool WebSocketClient::send_message(const ws_message& message) {
     return impl_->send_message(message);
 }
 
+bool WebSocketClient::send_message(ws_message&& message) {
+    return impl_->send_message(std::move(message));
+}
+
+bool WebSocketClient::send_message(ws_message::message_type type, std::shared_ptr<const std::string> payload) {
+    return impl_->send_message(type, std::move(payload));
+}
+
+bool WebSocketClient::send_batch(std::vector<ws_message>&& messages) {
+    return impl_->send_batch(std::move(messages));
+}
+
 void WebSocketClient::send_text(const std::string& text) {
     impl_->send_text(text);
 }
 
+void WebSocketClient::send_text(std::string&& text) {
+    impl_->send_text(std::move(text));
+}
+
 void WebSocketClient::send_binary(const std::string& data) {
     impl_->send_binary(data);
 }
 
+void WebSocketClient::send_binary(std::string&& data) {
+    impl_->send_binary(std::move(data));
+}
+
 void WebSocketClient::set_message_callback(MessageCallback callback) {
     impl_->set_message_callback(std::move(callback));
 }
 
+void WebSocketClient::set_message_callback(MessageViewCallback callback) {
+    impl_->set_message_view_callback(std::move(callback));
+}
+
 void WebSocketClient::set_state_callback(StateCallback callback) {
     impl_->set_state_callback(std::move(callback));
 }
@@ -377,6 +556,18 @@ uint64_t WebSocketClient::get_messages_received() const {
     return impl_->get_messages_received();
 }
 
+HistogramSnapshot WebSocketClient::get_rtt_stats() const {
+    return impl_->get_rtt_stats();
+}
+
+HistogramSnapshot WebSocketClient::get_round_trip_latency_stats() const {
+    return impl_->get_round_trip_latency_stats();
+}
+
+HistogramSnapshot WebSocketClient::get_one_way_latency_stats() const {
+    return impl_->get_one_way_latency_stats();
+}
+
 // ========== ClientManager 实现 ==========
 
 ClientManager& ClientManager::instance() {
@@ -394,7 +585,11 @@ std::shared_ptr<WebSocketClient> ClientManager::create_client(const std::string&
         return nullptr;
     }
 
-    auto client = std::make_shared<WebSocketClient>(id);
+    if (!io_pool_) {
+        io_pool_ = std::make_shared<core::IoPool>();
+    }
+
+    auto client = std::make_shared<WebSocketClient>(id, io_pool_);
     clients_[id] = client;
 
     Logger::info("创建客户端: " + id);
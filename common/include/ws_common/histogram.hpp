@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace KK_WS {
+
+/**
+ * @brief 直方图快照
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    double mean = 0.0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+};
+
+/**
+ * @brief 无锁的对数-线性直方图（HDR风格）
+ *
+ * 按2的幂分组，每组再线性分为16个子桶，相对误差约6%，覆盖 [0, 2^48)。
+ * 与Counter相同，桶、计数、总和与最值按线程分片（Shards个，线程首次记录时
+ * 轮转分配），record()只修改本线程分片所在的缓存行，多个IO线程同时记录时
+ * 互不争用；snapshot()和导出时合并所有分片，读到的是近似一致的视图。
+ *
+ * 每个分片约6KB，多线程共享的指标使用Histogram；只有一个线程写入的统计
+ * （如单个连接的延迟）使用LocalHistogram，不必为分片付出内存。
+ */
+template <size_t Shards>
+class BasicHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+    static constexpr unsigned kMaxBits = 48;
+    static constexpr size_t kBucketCount = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+    static constexpr size_t kShards = Shards;
+
+    static_assert(Shards > 0, "直方图至少需要一个分片");
+
+    void record(uint64_t value) {
+        Shard& shard = shards_[shard_index()];
+        shard.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+
+        // 只有出现新的最值时才写入，稳定后只是一次本分片的读取
+        uint64_t current = shard.min.load(std::memory_order_relaxed);
+        while (value < current &&
+               !shard.min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+        current = shard.max.load(std::memory_order_relaxed);
+        while (value > current &&
+               !shard.max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    HistogramSnapshot snapshot() const {
+        Buckets merged;
+        HistogramSnapshot snap;
+        snap.count = merge_buckets(merged);
+        if (snap.count == 0) {
+            return snap;
+        }
+        snap.min = merged_min();
+        snap.max = merged_max();
+        snap.mean = static_cast<double>(sum()) / snap.count;
+        snap.p50 = percentile(merged, snap.count, snap.max, 0.50);
+        snap.p90 = percentile(merged, snap.count, snap.max, 0.90);
+        snap.p99 = percentile(merged, snap.count, snap.max, 0.99);
+        snap.p999 = percentile(merged, snap.count, snap.max, 0.999);
+        return snap;
+    }
+
+    /**
+     * @brief 第q分位数（0~1），返回所在桶的上界，并截断到实际最大值
+     */
+    uint64_t percentile(double q) const {
+        Buckets merged;
+        const uint64_t total = merge_buckets(merged);
+        return percentile(merged, total, merged_max(), q);
+    }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t sum() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.sum.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * @brief 第i个桶的计数（所有分片之和）和上界，用于导出（如Prometheus）
+     */
+    uint64_t bucket_count(size_t i) const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    static uint64_t bucket_upper_bound(size_t index) {
+        const size_t group = index / kSubBuckets;
+        const uint64_t sub = index % kSubBuckets;
+        if (group == 0) {
+            return sub;
+        }
+        const unsigned shift = static_cast<unsigned>(group - 1);
+        return ((kSubBuckets + sub + 1) << shift) - 1;
+    }
+
+    void reset() {
+        for (auto& shard : shards_) {
+            for (auto& bucket : shard.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            shard.count.store(0, std::memory_order_relaxed);
+            shard.sum.store(0, std::memory_order_relaxed);
+            shard.min.store(UINT64_MAX, std::memory_order_relaxed);
+            shard.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    using Buckets = std::array<uint64_t, kBucketCount>;
+
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+    };
+
+    // 线程首次记录时按轮转分配分片，此后固定不变
+    static size_t shard_index() {
+        if constexpr (Shards == 1) {
+            return 0;
+        } else {
+            static std::atomic<size_t> next{0};
+            thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+            return index;
+        }
+    }
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        if (value >> kMaxBits) {
+            return kBucketCount - 1;
+        }
+        // 最高位决定组号，其后的kSubBucketBits位决定组内子桶
+        unsigned msb = 63;
+        while (!(value >> msb)) {
+            --msb;
+        }
+        const unsigned shift = msb - kSubBucketBits;
+        const size_t group = shift + 1;
+        const size_t sub = static_cast<size_t>((value >> shift) - kSubBuckets);
+        return group * kSubBuckets + sub;
+    }
+
+    // 合并所有分片的桶，返回合并后的总数（与桶计数一致，不受并发记录影响）
+    uint64_t merge_buckets(Buckets& merged) const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            merged[i] = bucket_count(i);
+            total += merged[i];
+        }
+        return total;
+    }
+
+    static uint64_t percentile(const Buckets& merged, uint64_t total, uint64_t max, double q) {
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t target = static_cast<uint64_t>(q * total + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += merged[i];
+            if (seen >= target && seen > 0) {
+                const uint64_t upper = bucket_upper_bound(i);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+
+    uint64_t merged_min() const {
+        uint64_t result = UINT64_MAX;
+        for (const auto& shard : shards_) {
+            result = std::min(result, shard.min.load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+    uint64_t merged_max() const {
+        uint64_t result = 0;
+        for (const auto& shard : shards_) {
+            result = std::max(result, shard.max.load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+private:
+    std::array<Shard, Shards> shards_{};
+};
+
+// 多线程共享的直方图（指标注册表中的直方图），分片数与Counter相同
+using Histogram = BasicHistogram<16>;
+// 只有一个线程写入的直方图
+using LocalHistogram = BasicHistogram<1>;
+
+} // namespace KK_WS
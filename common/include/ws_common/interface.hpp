@@ -1,8 +1,20 @@
 #pragma once
 #include <string>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
 
 namespace KK_WS { // 创建websockets的命名空间
+    // 单调时钟的纳秒时间戳（steady_clock），同一台主机上的不同进程之间可以直接比较
+    inline uint64_t monotonic_now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
     // 枚举ws的连接状态
     enum class ws_connection_state{
         WS_DISCONNECTED, // 断开连接
@@ -12,6 +24,17 @@ namespace KK_WS { // 创建websockets的命名空间
         WS_FAILED        // 连接失败
     };
 
+    // permessage-deflate压缩配置（RFC 7692）
+    struct ws_compression_config{
+        bool enabled = false; // 是否协商压缩，默认关闭
+        size_t min_size = 256; // 小于该字节数的消息不压缩
+        int level = 6; // zlib压缩级别 1~9
+        bool server_no_context_takeover = false; // 服务器每条消息后重置压缩上下文
+        bool client_no_context_takeover = false; // 客户端每条消息后重置压缩上下文
+        uint8_t server_max_window_bits = 15; // 服务器LZ77窗口位数 8~15（本端压缩时至少按9位）
+        uint8_t client_max_window_bits = 15; // 客户端LZ77窗口位数 8~15（本端压缩时至少按9位）
+    };
+
     // 配置结构
     struct ws_config{
         std::string uri; // WebSocket服务器的URI
@@ -19,9 +42,14 @@ namespace KK_WS { // 创建websockets的命名空间
         uint16_t port = 9002; // 端口号，默认9002
         bool use_ssl = false; // 是否使用SSL，默认不使用
         bool enable_auto_reconnect = true; // 是否启用自动重连，默认启用
-        int ping_interval_ms = 10000; // 心跳间隔时间，单位毫秒，默认10秒
-        int reconnect_interval_ms = 5000; // 重连间隔时间，单位毫秒，默认5秒
-        int max_reconnect_attempts = 5; // 最大重连次数，默认5次
+        int ping_interval_ms = 10000; // 心跳间隔时间，单位毫秒，默认10秒，0表示关闭心跳
+        int pong_timeout_ms = 5000; // 等待pong的超时时间，超时即判定连接失效
+        int reconnect_interval_ms = 5000; // 重连退避的基础间隔，单位毫秒，默认5秒
+        int reconnect_max_interval_ms = 60000; // 重连退避的上限，单位毫秒，默认60秒
+        int max_reconnect_attempts = 5; // 最大重连次数，默认5次，0表示不限
+        int connect_timeout_ms = 5000; // 握手超时时间，单位毫秒，默认5秒
+        ws_compression_config compression; // 消息压缩配置
+        bool latency_envelope = false; // 在文本/二进制消息负载前附加发送时间戳（见latency_envelope.hpp），收到时剥离并统计延迟
 
         // 验证配置有效性
         bool validate() const {
@@ -41,18 +69,38 @@ namespace KK_WS { // 创建websockets的命名空间
 
         message_type type; // 消息类型
         std::string payload; // 消息内容
-        uint16_t time_stamp; // 时间戳
+        uint64_t time_stamp; // 单调时钟纳秒时间戳（monotonic_now_ns()）：接收时为收到帧的时刻，发送时为调用发送的时刻；0表示未设置
 
         // 构造函数
-        ws_message(message_type t, const std::string& p, uint16_t ts)
+        ws_message(message_type t, const std::string& p, uint64_t ts = 0)
             : type(t), payload(p), time_stamp(ts) {}
+        // 接管负载缓冲区，不拷贝
+        ws_message(message_type t, std::string&& p, uint64_t ts = 0)
+            : type(t), payload(std::move(p)), time_stamp(ts) {}
         
     };
 
+    // 零拷贝的接收消息视图
+    //   payload直接指向底层收到的缓冲区，owner持有该缓冲区的引用计数，
+    //   接收方可以只读取视图，也可以复制整个ws_message_view以延长缓冲区寿命，均不拷贝负载
+    struct ws_message_view{
+        ws_message::message_type type; // 消息类型
+        std::string_view payload; // 消息内容（owner存活期间有效）
+        std::shared_ptr<const void> owner; // 底层缓冲区的所有者
+        uint64_t time_stamp = 0; // 收到帧时的单调时钟纳秒时间戳
+
+        // 需要独立副本时显式转换（会拷贝负载）
+        ws_message to_message() const {
+            return ws_message(type, std::string(payload), time_stamp);
+        }
+    };
+
 // 回调类型定义
 using MessageCallback = std::function<void(const ws_message&)>;
+using MessageViewCallback = std::function<void(const ws_message_view&)>;
 using StateCallback = std::function<void(ws_connection_state)>;
 using ErrorCallback = std::function<void(const std::string&)>;
+using ConnectCallback = std::function<void(bool success, const std::string& error)>;
 
     // IWebSocketEndpoint接口类
     class IWebSocketEndpoint{
@@ -60,15 +108,20 @@ using ErrorCallback = std::function<void(const std::string&)>;
         virtual ~IWebSocketEndpoint() = default; // 默认析构函数
 
         // 连接管理
-        virtual bool connect(const ws_config& config) = 0; // 连接到WebSocket服务器
+        virtual bool connect(const ws_config& config) = 0; // 连接到WebSocket服务器（阻塞直到成功、失败或超时）
+        virtual void async_connect(const ws_config& config, ConnectCallback callback) = 0; // 异步连接，完成时在IO线程上回调
         virtual void disconnect() = 0; // 断开与WebSocket服务器的连接
         virtual ws_connection_state get_connection_state() const = 0; // 获取当前连接状态
 
         // 消息处理
-        virtual bool send_message(const ws_message& message) = 0; // 发送消息
+        virtual bool send_message(const ws_message& message) = 0; // 发送消息（拷贝负载）
+        virtual bool send_message(ws_message&& message) = 0; // 发送消息，负载缓冲区直接移交给发送帧
+        virtual bool send_message(ws_message::message_type type,
+                                  std::shared_ptr<const std::string> payload) = 0; // 发送共享缓冲区中的负载
 
         // 回调设置
-        virtual void set_message_callback(MessageCallback callback) = 0; // 设置消息回调
+        virtual void set_message_callback(MessageCallback callback) = 0; // 设置消息回调（负载拷贝到ws_message）
+        virtual void set_message_callback(MessageViewCallback callback) = 0; // 设置零拷贝消息回调
         virtual void set_state_callback(StateCallback callback) = 0; // 设置状态回调
         virtual void set_error_callback(ErrorCallback callback) = 0; // 设置错误回调
         
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace KK_WS::latency_envelope {
+
+/**
+ * @brief 延迟测量信封：附加在消息负载前的发送时间戳
+ *
+ * 格式为纯ASCII，文本帧中仍是合法的UTF-8：
+ *   "#lat:" + 16位十六进制发送时间(纳秒) + ":" + 8位十六进制发送方标识 + "|"
+ *
+ * 时间戳取自单调时钟（monotonic_now_ns()），只有收发两端在同一台主机上时
+ * 单向延迟才有意义；发送方收到带有自己标识的信封（例如服务器原样回显）
+ * 时得到的是往返延迟，与主机无关。
+ */
+constexpr std::string_view kPrefix = "#lat:";
+constexpr size_t kSize = 5 + 16 + 1 + 8 + 1;
+
+struct Stamp {
+    uint64_t sent_ns = 0;   // 发送方的单调时钟时间戳
+    uint32_t origin = 0;    // 发送方标识
+};
+
+namespace detail {
+
+inline void append_hex(std::string& out, uint64_t value, int digits) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        out += kHex[(value >> shift) & 0xf];
+    }
+}
+
+inline bool parse_hex(std::string_view text, uint64_t& value) {
+    value = 0;
+    for (char c : text) {
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint64_t>(digit);
+    }
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief 生成信封头
+ */
+inline std::string encode(const Stamp& stamp) {
+    std::string header;
+    header.reserve(kSize);
+    header += kPrefix;
+    detail::append_hex(header, stamp.sent_ns, 16);
+    header += ':';
+    detail::append_hex(header, stamp.origin, 8);
+    header += '|';
+    return header;
+}
+
+/**
+ * @brief 在负载前插入信封头
+ */
+inline void prepend(std::string& payload, const Stamp& stamp) {
+    payload.insert(0, encode(stamp));
+}
+
+/**
+ * @brief 解析负载开头的信封，不是信封时返回空；负载正文为payload.substr(kSize)
+ */
+inline std::optional<Stamp> parse(std::string_view payload) {
+    if (payload.size() < kSize || payload.substr(0, kPrefix.size()) != kPrefix ||
+        payload[kPrefix.size() + 16] != ':' || payload[kSize - 1] != '|') {
+        return std::nullopt;
+    }
+
+    uint64_t sent_ns = 0;
+    uint64_t origin = 0;
+    if (!detail::parse_hex(payload.substr(kPrefix.size(), 16), sent_ns) ||
+        !detail::parse_hex(payload.substr(kPrefix.size() + 17, 8), origin)) {
+        return std::nullopt;
+    }
+    return Stamp{sent_ns, static_cast<uint32_t>(origin)};
+}
+
+} // namespace KK_WS::latency_envelope
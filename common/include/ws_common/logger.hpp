@@ -1,14 +1,106 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <sstream>
 #include <mutex>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+// 编译期最低日志级别：0=DEBUG 1=INFO 2=WARNING 3=ERROR
+// 低于该级别的debugf()/infof()等调用在编译期即被判定为关闭，连同参数格式化一起被优化掉。
+// Release构建（定义了NDEBUG）默认去掉DEBUG日志，可通过 -DWS_LOG_MIN_LEVEL=0 保留。
+#ifndef WS_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define WS_LOG_MIN_LEVEL 1
+#else
+#define WS_LOG_MIN_LEVEL 0
+#endif
+#endif
 
 namespace KK_WS {
 
+namespace log_detail {
+
+/**
+ * @brief 截断显示的文本参数，见Logger::preview()
+ */
+struct Preview {
+    std::string_view text;
+    size_t max_length;
+};
+
+inline void append_arg(std::string& out, std::string_view value) {
+    out.append(value.data(), value.size());
+}
+
+inline void append_arg(std::string& out, const Preview& value) {
+    if (value.text.size() <= value.max_length) {
+        append_arg(out, value.text);
+        return;
+    }
+    append_arg(out, value.text.substr(0, value.max_length));
+    out += "...";
+}
+
+template <typename T>
+void append_arg(std::string& out, const T& value) {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        append_arg(out, std::string_view(value));
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out += value ? "true" : "false";
+    } else if constexpr (std::is_same_v<T, char>) {
+        out += value;
+    } else if constexpr (std::is_integral_v<T>) {
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, result.ptr);
+    } else if constexpr (std::is_enum_v<T>) {
+        append_arg(out, static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        char buf[32];
+        int length = std::snprintf(buf, sizeof(buf), "%g", static_cast<double>(value));
+        out.append(buf, length > 0 ? static_cast<size_t>(length) : 0);
+    } else if constexpr (std::is_invocable_v<const T&>) {
+        // 延迟求值：只有日志确实输出时才调用
+        append_arg(out, value());
+    } else {
+        std::ostringstream oss;
+        oss << value;
+        out += oss.str();
+    }
+}
+
+// 依次用参数替换fmt中的 "{}"，多余的参数被忽略
+inline void format_to(std::string& out, std::string_view fmt) {
+    append_arg(out, fmt);
+}
+
+template <typename T, typename... Rest>
+void format_to(std::string& out, std::string_view fmt, const T& first, const Rest&... rest) {
+    const size_t pos = fmt.find("{}");
+    if (pos == std::string_view::npos) {
+        append_arg(out, fmt);
+        return;
+    }
+    append_arg(out, fmt.substr(0, pos));
+    append_arg(out, first);
+    format_to(out, fmt.substr(pos + 2), rest...);
+}
+
+} // namespace log_detail
+
 /**
  * @brief 简单的线程安全日志类
+ *
+ * 默认同步输出：每条日志在调用线程上格式化并写出。
+ * 标准输出只在WARN/ERROR时立即刷新，其余级别需要时调用flush()。
+ * start_async()之后切换为异步模式：调用线程只把记录放入有界无锁环形缓冲区，
+ * 由一个后台线程批量格式化和写出；缓冲区满时丢弃新记录并计数。
  */
 class Logger {
 public:
@@ -19,15 +111,124 @@ public:
         Ws_ERROR
     };
 
-    static void debug(const std::string& msg);
-    static void info(const std::string& msg);
-    static void warning(const std::string& msg);
-    static void error(const std::string& msg);
-    
+    static void debug(std::string msg);
+    static void info(std::string msg);
+    static void warning(std::string msg);
+    static void error(std::string msg);
+
     static void set_level(Level level);
 
+    // 编译期最低级别，见WS_LOG_MIN_LEVEL
+    static constexpr Level kMinLevel = static_cast<Level>(WS_LOG_MIN_LEVEL);
+
+    /**
+     * @brief 该级别的日志是否会输出
+     */
+    static bool enabled(Level level) {
+        return level >= kMinLevel && level >= current_level_;
+    }
+
+    /**
+     * @brief 格式化风格的日志，"{}"依次替换为参数
+     *
+     * 先检查级别再格式化：级别关闭时不拼接字符串、不分配内存。参数可以是字符串、
+     * 数字、preview()的结果，或者返回这些类型的可调用对象（只在输出时调用）。
+     * 例如: Logger::debugf("收到消息: {} ({} 字节)", Logger::preview(payload, 50), payload.size());
+     */
+    template <typename... Args>
+    static void logf(Level level, std::string_view fmt, const Args&... args) {
+        if (!enabled(level)) {
+            return;
+        }
+        std::string msg;
+        msg.reserve(fmt.size() + 16 * sizeof...(Args));
+        log_detail::format_to(msg, fmt, args...);
+        log(level, std::move(msg));
+    }
+
+    template <typename... Args>
+    static void debugf(std::string_view fmt, const Args&... args) {
+        if constexpr (Level::Ws_DEBUG >= kMinLevel) {
+            logf(Level::Ws_DEBUG, fmt, args...);
+        }
+    }
+
+    template <typename... Args>
+    static void infof(std::string_view fmt, const Args&... args) {
+        if constexpr (Level::Ws_INFO >= kMinLevel) {
+            logf(Level::Ws_INFO, fmt, args...);
+        }
+    }
+
+    template <typename... Args>
+    static void warningf(std::string_view fmt, const Args&... args) {
+        if constexpr (Level::Ws_WARNING >= kMinLevel) {
+            logf(Level::Ws_WARNING, fmt, args...);
+        }
+    }
+
+    template <typename... Args>
+    static void errorf(std::string_view fmt, const Args&... args) {
+        logf(Level::Ws_ERROR, fmt, args...);
+    }
+
+    /**
+     * @brief 只显示前max_length个字节的文本参数，超出部分显示为"..."，不拷贝原文
+     */
+    static log_detail::Preview preview(std::string_view text, size_t max_length) {
+        return {text, max_length};
+    }
+
+    /**
+     * @brief 启用异步模式（已启用时忽略）
+     * @param capacity 环形缓冲区容量（条），向上取整为2的幂
+     */
+    static void start_async(size_t capacity = 8192);
+
+    /**
+     * @brief 写出所有已缓冲的记录并停止后台线程，之后恢复同步输出
+     *
+     * 进程正常退出时会自动调用，保证已接受的记录不丢失。
+     */
+    static void stop_async();
+
+    /**
+     * @brief 等待调用前已缓冲的记录全部写出（同步模式下只刷新输出流）
+     */
+    static void flush();
+
+    /**
+     * @brief 异步模式下因缓冲区已满或正在停止而丢弃的记录数（累计）
+     */
+    static uint64_t dropped_count();
+
+    /**
+     * @brief 同时写入内存映射的滚动日志文件（见MmapFileSink）
+     *
+     * 与标准输出并存，可用set_console_output(false)只写文件。
+     * 已有文件输出时先关闭旧文件。
+     * @param segment_bytes 每个日志段的大小
+     * @param max_segments 保留的段数（含当前段）
+     * @return 文件创建或映射失败时返回false
+     */
+    static bool set_file_output(const std::string& path,
+                                size_t segment_bytes = 64 * 1024 * 1024,
+                                size_t max_segments = 5);
+
+    /**
+     * @brief 关闭文件输出，当前段截断到实际长度
+     */
+    static void close_file_output();
+
+    /**
+     * @brief 开启或关闭标准输出（默认开启）
+     */
+    static void set_console_output(bool enabled);
+
 private:
-    static void log(Level level, const std::string& msg);
+    static void log(Level level, std::string msg);
+    // 将已格式化的若干行写到所有输出，调用方不能持有log_mutex_；flush_console为false时不刷新标准输出
+    static void write_output(const std::string& text, bool flush_console);
     static std::mutex log_mutex_;
     static Level current_level_;
     static const char* level_to_string(Level level);
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ws_common/histogram.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace KK_WS {
+
+/**
+ * @brief 分片的单调递增计数器
+ *
+ * 每个线程固定落在kShards个缓存行对齐的槽位之一，多个IO线程同时计数时
+ * 不会争用同一缓存行；value()读取时再把各槽位相加。
+ */
+class Counter {
+public:
+    static constexpr size_t kShards = 16;
+
+    void add(uint64_t n = 1) {
+        shards_[shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+
+    // 线程首次计数时按轮转分配槽位，此后固定不变
+    static size_t shard_index() {
+        static std::atomic<size_t> next{0};
+        thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return index;
+    }
+
+    std::array<Cell, kShards> shards_{};
+};
+
+/**
+ * @brief 可增可减的瞬时值
+ */
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    void sub(int64_t n = 1) { value_.fetch_sub(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief 指标注册表，导出为Prometheus文本格式
+ *
+ * 注册（counter()/gauge()/histogram()）在启动时进行，需要加锁；返回的引用在
+ * 注册表的生命周期内有效，热路径上直接操作该引用，不再经过注册表。
+ * 同名指标重复注册时返回已有的实例。
+ */
+class MetricsRegistry {
+public:
+    using GaugeFunction = std::function<double()>;
+
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+
+    /**
+     * @brief 注册直方图
+     * @param scale 导出时乘以的系数，例如记录纳秒、以秒导出时为1e-9
+     */
+    Histogram& histogram(const std::string& name, const std::string& help, double scale = 1.0);
+
+    /**
+     * @brief 注册一个在导出时才求值的瞬时值（例如遍历连接求和的队列深度）
+     *
+     * fn在导出线程上调用，必须线程安全。
+     */
+    void gauge_function(const std::string& name, const std::string& help, GaugeFunction fn);
+
+    /**
+     * @brief 以Prometheus文本格式（0.0.4）追加所有指标到out
+     */
+    void render_prometheus(std::string& out) const;
+    std::string render_prometheus() const;
+
+    /**
+     * @brief 进程级的默认注册表，供没有所属对象的模块（如core::Connection）使用
+     */
+    static MetricsRegistry& global();
+
+private:
+    enum class Type : int;
+    struct Entry;
+
+    Entry& find_or_add(const std::string& name, const std::string& help, Type type);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+} // namespace KK_WS
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace KK_WS {
+
+/**
+ * @brief 基于内存映射的滚动日志文件
+ *
+ * 每个日志段创建时即预分配segment_bytes字节并整体映射到内存，写日志只是一次
+ * memcpy，不产生系统调用；只有段写满滚动时才会关闭旧段并创建新段。
+ *
+ * 文件命名：当前段为path，滚动时 path → path.1 → path.2 ...，
+ * 共保留max_segments个段（含当前段），最旧的段被删除。
+ * 打开时若path已存在且非空，先将其滚动为path.1，不会覆盖旧日志。
+ *
+ * 当前段在关闭之前文件长度为segment_bytes，未写部分为0；
+ * close()或析构时截断到实际写入的长度。
+ */
+class MmapFileSink {
+public:
+    /**
+     * @param path 当前日志段的文件路径
+     * @param segment_bytes 每个段的大小（字节）
+     * @param max_segments 保留的段数（至少为1）
+     */
+    MmapFileSink(std::string path, size_t segment_bytes, size_t max_segments);
+    ~MmapFileSink();
+
+    // 禁止拷贝和移动
+    MmapFileSink(const MmapFileSink&) = delete;
+    MmapFileSink& operator=(const MmapFileSink&) = delete;
+
+    /**
+     * @brief 创建并映射第一个段
+     * @return 创建、预分配或映射失败时返回false
+     */
+    bool open();
+
+    /**
+     * @brief 追加数据，当前段写满时自动滚动
+     * @return 滚动失败（此后的数据被丢弃）时返回false
+     */
+    bool write(std::string_view data);
+
+    /**
+     * @brief 请求操作系统异步回写已修改的页
+     */
+    void flush();
+
+    /**
+     * @brief 解除映射并把当前段截断到实际长度
+     */
+    void close();
+
+    bool is_open() const;
+    const std::string& path() const { return path_; }
+
+private:
+    bool open_segment();
+    void close_segment();
+    void rotate_files();
+
+private:
+    struct Mapping;
+
+    std::string path_;
+    size_t segment_bytes_;
+    size_t max_segments_;
+
+    std::unique_ptr<Mapping> mapping_;
+    size_t offset_ = 0;  // 当前段已写入的字节数
+};
+
+} // namespace KK_WS
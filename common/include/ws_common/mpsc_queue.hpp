@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace KK_WS {
+
+/**
+ * @brief 无锁的多生产者/单消费者队列（Vyukov侵入式链表）
+ *
+ * push()只做一次原子exchange和一次store，任意线程可以并发调用；
+ * pop()只能由同一个消费者线程调用。队列无界，每个元素占用一个链表节点。
+ *
+ * 生产者exchange尾指针之后、链接next之前的短暂窗口内，pop()会把
+ * 队列视为空。调用方应在push()完成之后再通知消费者，这样消费者
+ * 总会在之后的某次pop()中取到该元素。
+ */
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    ~MpscQueue() {
+        while (pop()) {
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * @brief 取出队首元素，队列为空（或队首尚未链接完成）时返回空
+     */
+    std::optional<T> pop() {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &stub_) {
+            if (!next) {
+                return std::nullopt;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next) {
+            tail_ = next;
+            return take(tail);
+        }
+
+        if (tail != head_.load(std::memory_order_acquire)) {
+            // 有生产者正在链接新节点
+            return std::nullopt;
+        }
+
+        // 队列中只剩最后一个节点：重新挂上stub，使tail可以安全前进
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+        prev->next.store(&stub_, std::memory_order_release);
+
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return take(tail);
+        }
+        return std::nullopt;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T&& v) : value(std::move(v)) {}
+
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    static std::optional<T> take(Node* node) {
+        std::optional<T> value(std::move(node->value));
+        delete node;
+        return value;
+    }
+
+private:
+    alignas(64) std::atomic<Node*> head_;  // 生产者端
+    alignas(64) Node* tail_;               // 消费者端
+    Node stub_;
+};
+
+} // namespace KK_WS
@@ -1,13 +1,295 @@
 #include "ws_common/logger.hpp"
+#include "ws_common/mmap_file_sink.hpp"
+#include <atomic>
 #include <chrono>
-#include <iomanip>
+#include <condition_variable>
+#include <cstdio>
 #include <ctime>
+#include <functional>
+#include <memory>
+#include <thread>
 
 namespace KK_WS {
 
+// 先于下方的退出守卫构造，保证守卫析构时仍然可用
 std::mutex Logger::log_mutex_;
 Logger::Level Logger::current_level_ = Level::Ws_INFO;
 
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+/**
+ * @brief 一条待写出的日志记录
+ */
+struct Record {
+    const char* level = "";
+    Clock::time_point time;
+    std::string msg;
+};
+
+/**
+ * @brief 追加一行格式化后的日志: [时间] [级别] 消息
+ *
+ * 同一秒内的日志复用上次localtime的结果，只重新格式化毫秒部分。
+ */
+void append_line(std::string& out, const Record& record) {
+    struct SecondCache {
+        std::time_t second = -1;
+        char text[32] = {};
+        size_t length = 0;
+    };
+    thread_local SecondCache cache;
+
+    const std::time_t second = Clock::to_time_t(record.time);
+    if (second != cache.second) {
+        std::tm tm_buf;
+#ifdef _WIN32
+        localtime_s(&tm_buf, &second);
+#else
+        localtime_r(&second, &tm_buf);
+#endif
+        cache.length = std::strftime(cache.text, sizeof(cache.text), "%Y-%m-%d %H:%M:%S", &tm_buf);
+        cache.second = second;
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        record.time.time_since_epoch()).count() % 1000;
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(ms));
+
+    out += '[';
+    out.append(cache.text, cache.length);
+    out += millis;
+    out += "] [";
+    out += record.level;
+    out += "] ";
+    out += record.msg;
+    out += '\n';
+}
+
+/**
+ * @brief 有界的多生产者/单消费者环形缓冲区（Vyukov有界队列）
+ *
+ * 每个槽位带一个序号，生产者通过CAS领取写入位置，写完后发布序号；
+ * 缓冲区满时push()立即返回false，不阻塞调用线程。
+ */
+class RecordRing {
+public:
+    explicit RecordRing(size_t capacity)
+        : mask_(round_up(capacity) - 1)
+        , slots_(new Slot[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(Record&& record) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->record = std::move(record);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 只能由消费者线程调用
+    bool pop(Record& record) {
+        Slot& slot = slots_[dequeue_pos_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            return false;
+        }
+        record = std::move(slot.record);
+        slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Record record;
+    };
+
+    static size_t round_up(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0;
+};
+
+/**
+ * @brief 异步日志后端：环形缓冲区 + 一个后台写线程
+ */
+class AsyncBackend {
+public:
+    using Writer = std::function<void(const std::string& batch)>;
+
+    AsyncBackend(size_t capacity, Writer writer)
+        : ring_(capacity)
+        , writer_(std::move(writer))
+        , thread_([this]() { run(); }) {
+    }
+
+    ~AsyncBackend() {
+        stop();
+    }
+
+    // 开始停止后不再接受记录（计为丢弃）；后台线程退出前会等正在进行的push()结束
+    bool push(Record&& record) {
+        pushers_.fetch_add(1);
+        if (stopping_.load()) {
+            pushers_.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        const bool accepted = ring_.push(std::move(record));
+        if (accepted) {
+            accepted_.fetch_add(1, std::memory_order_release);
+            if (sleeping_.load(std::memory_order_acquire)) {
+                wake_cv_.notify_one();
+            }
+        }
+        pushers_.fetch_sub(1, std::memory_order_release);
+        return accepted;
+    }
+
+    void flush() {
+        const uint64_t target = accepted_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_cv_.notify_one();
+        flushed_cv_.wait(lock, [this, target]() {
+            return written_ >= target || !running_;
+        });
+    }
+
+    // 写出缓冲区中的全部记录后结束后台线程
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            stopping_.store(true);
+            running_ = false;
+        }
+        wake_cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void run() {
+        std::string batch;
+        Record record;
+
+        for (;;) {
+            if (write_batch(batch, record) > 0) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!running_) {
+                break;
+            }
+            sleeping_.store(true, std::memory_order_release);
+            // 生产者只在看到sleeping_时才通知，超时兜底处理通知与入睡之间的竞争
+            wake_cv_.wait_for(lock, kIdleWait);
+            sleeping_.store(false, std::memory_order_release);
+        }
+
+        // stopping_之后push()不再成功：等已越过检查的push()完成，再写出剩余记录
+        while (pushers_.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        while (write_batch(batch, record) > 0) {
+        }
+
+        flushed_cv_.notify_all();
+    }
+
+    // 取出最多kMaxBatch条记录一次写出，返回写出的条数
+    size_t write_batch(std::string& batch, Record& record) {
+        size_t count = 0;
+        while (count < kMaxBatch && ring_.pop(record)) {
+            append_line(batch, record);
+            ++count;
+        }
+        if (count == 0) {
+            return 0;
+        }
+
+        writer_(batch);
+        batch.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        written_ += count;
+        flushed_cv_.notify_all();
+        return count;
+    }
+
+private:
+    static constexpr size_t kMaxBatch = 512;
+    static constexpr std::chrono::milliseconds kIdleWait{10};
+
+    RecordRing ring_;
+    Writer writer_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    bool running_ = true;
+    uint64_t written_ = 0;  // 受mutex_保护
+
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<bool> sleeping_{false};
+    // push()与stop()之间用顺序一致的原子操作配对：要么push()看到stopping_而失败，
+    // 要么后台线程看到pushers_不为0而等待
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> pushers_{0};
+
+    std::thread thread_;  // 最后构造，启动时其余成员已就绪
+};
+
+// 通过std::atomic_load/atomic_store访问；为空表示同步模式
+std::shared_ptr<AsyncBackend> g_async_backend;
+
+// 输出目标，受Logger::log_mutex_保护
+std::unique_ptr<MmapFileSink> g_file_sink;
+bool g_console_output = true;
+std::mutex g_async_control_mutex;  // 串行化start_async/stop_async
+std::atomic<uint64_t> g_dropped{0};
+
+// 进程正常退出时写出异步缓冲区中剩余的记录
+struct AsyncShutdownGuard {
+    ~AsyncShutdownGuard() {
+        Logger::stop_async();
+    }
+} g_async_shutdown_guard;
+
+} // namespace
+
 const char* Logger::level_to_string(Level level) {
     switch (level) {
         case Level::Ws_DEBUG:   return "DEBUG";
@@ -18,55 +300,117 @@ const char* Logger::level_to_string(Level level) {
     }
 }
 
-void Logger::log(Level level, const std::string& msg) {
-    if (level < current_level_) {
+void Logger::log(Level level, std::string msg) {
+    if (!enabled(level)) {
+        return;
+    }
+
+    Record record{level_to_string(level), Clock::now(), std::move(msg)};
+
+    if (auto backend = std::atomic_load(&g_async_backend)) {
+        if (!backend->push(std::move(record))) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
         return;
     }
 
+    std::string line;
+    append_line(line, record);
+    // 逐行刷新代价高，只有WARN/ERROR立即刷新，其余留给流缓冲或显式flush()
+    write_output(line, level >= Level::Ws_WARNING);
+}
+
+void Logger::write_output(const std::string& text, bool flush_console) {
     std::lock_guard<std::mutex> lock(log_mutex_);
-    
-    // 获取当前时间
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::tm tm_buf;
-#ifdef _WIN32
-    localtime_s(&tm_buf, &time_t);
-#else
-    localtime_r(&time_t, &tm_buf);
-#endif
-    
-    // 输出格式: [时间] [级别] 消息
-    std::cout << "["
-              << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S")
-              << "." << std::setfill('0') << std::setw(3) << ms.count()
-              << "] ["
-              << level_to_string(level)
-              << "] "
-              << msg
-              << std::endl;
+    if (g_console_output) {
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (flush_console) {
+            std::cout.flush();
+        }
+    }
+    if (g_file_sink) {
+        g_file_sink->write(text);
+    }
 }
 
-void Logger::debug(const std::string& msg) {
-    log(Level::Ws_DEBUG, msg);
+void Logger::debug(std::string msg) {
+    log(Level::Ws_DEBUG, std::move(msg));
 }
 
-void Logger::info(const std::string& msg) {
-    log(Level::Ws_INFO, msg);
+void Logger::info(std::string msg) {
+    log(Level::Ws_INFO, std::move(msg));
 }
 
-void Logger::warning(const std::string& msg) {
-    log(Level::Ws_WARNING, msg);
+void Logger::warning(std::string msg) {
+    log(Level::Ws_WARNING, std::move(msg));
 }
 
-void Logger::error(const std::string& msg) {
-    log(Level::Ws_ERROR, msg);
+void Logger::error(std::string msg) {
+    log(Level::Ws_ERROR, std::move(msg));
 }
 
 void Logger::set_level(Level level) {
     current_level_ = level;
 }
 
+void Logger::start_async(size_t capacity) {
+    std::lock_guard<std::mutex> control(g_async_control_mutex);
+    if (std::atomic_load(&g_async_backend)) {
+        return;
+    }
+
+    // 批量写出，每批只刷新一次输出流
+    auto backend = std::make_shared<AsyncBackend>(capacity, [](const std::string& batch) {
+        write_output(batch, true);
+    });
+    std::atomic_store(&g_async_backend, std::move(backend));
+}
+
+void Logger::stop_async() {
+    std::lock_guard<std::mutex> control(g_async_control_mutex);
+    auto backend = std::atomic_exchange(&g_async_backend, std::shared_ptr<AsyncBackend>());
+    if (backend) {
+        backend->stop();
+    }
+}
+
+void Logger::flush() {
+    if (auto backend = std::atomic_load(&g_async_backend)) {
+        backend->flush();
+    }
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    std::cout.flush();
+    if (g_file_sink) {
+        g_file_sink->flush();
+    }
+}
+
+uint64_t Logger::dropped_count() {
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+bool Logger::set_file_output(const std::string& path, size_t segment_bytes, size_t max_segments) {
+    auto sink = std::make_unique<MmapFileSink>(path, segment_bytes, max_segments);
+    if (!sink->open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    g_file_sink = std::move(sink);  // 旧文件在此析构并截断
+    return true;
+}
+
+void Logger::close_file_output() {
+    std::unique_ptr<MmapFileSink> sink;
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        sink = std::move(g_file_sink);
+    }
+}
+
+void Logger::set_console_output(bool enabled) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    g_console_output = enabled;
+}
+
 } // namespace ws
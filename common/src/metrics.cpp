@@ -0,0 +1,205 @@
+#include "ws_common/metrics.hpp"
+#include "ws_common/logger.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace KK_WS {
+
+enum class MetricsRegistry::Type : int {
+    Counter,
+    Gauge,
+    GaugeFunction,
+    Histogram
+};
+
+/**
+ * @brief 一个已注册的指标，按type只使用对应的成员
+ */
+struct MetricsRegistry::Entry {
+    std::string name;
+    std::string help;
+    Type type;
+    bool exported = true;  // 与已有指标重名但类型不同时不导出
+
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+    GaugeFunction function;
+    double scale = 1.0;
+};
+
+namespace {
+
+void append_number(std::string& out, double value) {
+    char buf[32];
+    const int length = std::snprintf(buf, sizeof(buf), "%.9g", value);
+    out.append(buf, length > 0 ? static_cast<size_t>(length) : 0);
+}
+
+void append_number(std::string& out, uint64_t value) {
+    out += std::to_string(value);
+}
+
+void append_header(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+/**
+ * @brief 以每个2的幂分组的上界作为Prometheus桶边界（累计计数）
+ *
+ * 组内16个子桶对Prometheus来说过细，合并后每个直方图约45个桶；
+ * bucket_count()/count()/sum()返回的已是所有线程分片之和。
+ */
+void append_histogram(std::string& out, const std::string& name, const Histogram& histogram, double scale) {
+    constexpr size_t kGroups = Histogram::kBucketCount / Histogram::kSubBuckets;
+
+    uint64_t cumulative = 0;
+    for (size_t group = 0; group < kGroups; ++group) {
+        for (size_t sub = 0; sub < Histogram::kSubBuckets; ++sub) {
+            cumulative += histogram.bucket_count(group * Histogram::kSubBuckets + sub);
+        }
+        const size_t last = (group + 1) * Histogram::kSubBuckets - 1;
+        out += name;
+        out += "_bucket{le=\"";
+        append_number(out, static_cast<double>(Histogram::bucket_upper_bound(last)) * scale);
+        out += "\"} ";
+        append_number(out, cumulative);
+        out += '\n';
+    }
+
+    // 各桶与count分别读取，并发记录时count可能略大于桶计数之和
+    const uint64_t count = std::max(cumulative, histogram.count());
+    out += name;
+    out += "_bucket{le=\"+Inf\"} ";
+    append_number(out, count);
+    out += '\n';
+
+    out += name;
+    out += "_sum ";
+    append_number(out, static_cast<double>(histogram.sum()) * scale);
+    out += '\n';
+
+    out += name;
+    out += "_count ";
+    append_number(out, count);
+    out += '\n';
+}
+
+} // namespace
+
+MetricsRegistry::MetricsRegistry() = default;
+MetricsRegistry::~MetricsRegistry() = default;
+
+MetricsRegistry::Entry& MetricsRegistry::find_or_add(const std::string& name, const std::string& help, Type type) {
+    bool exported = true;
+    for (auto& entry : entries_) {
+        if (entry->name != name || !entry->exported) {
+            continue;
+        }
+        if (entry->type == type) {
+            return *entry;
+        }
+        Logger::errorf("指标 {} 已注册为其他类型，新注册的实例不会被导出", name);
+        exported = false;
+        break;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->type = type;
+    entry->exported = exported;
+    entries_.push_back(std::move(entry));
+    return *entries_.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = find_or_add(name, help, Type::Counter);
+    if (!entry.counter) {
+        entry.counter = std::make_unique<Counter>();
+    }
+    return *entry.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = find_or_add(name, help, Type::Gauge);
+    if (!entry.gauge) {
+        entry.gauge = std::make_unique<Gauge>();
+    }
+    return *entry.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double scale) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = find_or_add(name, help, Type::Histogram);
+    if (!entry.histogram) {
+        entry.histogram = std::make_unique<Histogram>();
+        entry.scale = scale;
+    }
+    return *entry.histogram;
+}
+
+void MetricsRegistry::gauge_function(const std::string& name, const std::string& help, GaugeFunction fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    find_or_add(name, help, Type::GaugeFunction).function = std::move(fn);
+}
+
+void MetricsRegistry::render_prometheus(std::string& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+        if (!entry->exported) {
+            continue;
+        }
+        switch (entry->type) {
+            case Type::Counter:
+                append_header(out, entry->name, entry->help, "counter");
+                out += entry->name;
+                out += ' ';
+                append_number(out, entry->counter->value());
+                out += '\n';
+                break;
+            case Type::Gauge:
+                append_header(out, entry->name, entry->help, "gauge");
+                out += entry->name;
+                out += ' ';
+                out += std::to_string(entry->gauge->value());
+                out += '\n';
+                break;
+            case Type::GaugeFunction:
+                append_header(out, entry->name, entry->help, "gauge");
+                out += entry->name;
+                out += ' ';
+                append_number(out, entry->function ? entry->function() : 0.0);
+                out += '\n';
+                break;
+            case Type::Histogram:
+                append_header(out, entry->name, entry->help, "histogram");
+                append_histogram(out, entry->name, *entry->histogram, entry->scale);
+                break;
+        }
+    }
+}
+
+std::string MetricsRegistry::render_prometheus() const {
+    std::string out;
+    render_prometheus(out);
+    return out;
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+    // 有意不析构：静态对象析构阶段仍可能有连接在更新计数器
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+} // namespace KK_WS
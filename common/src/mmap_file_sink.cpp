@@ -0,0 +1,225 @@
+#include "ws_common/mmap_file_sink.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace KK_WS {
+
+/**
+ * @brief 一个已映射段的平台句柄
+ */
+struct MmapFileSink::Mapping {
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    char* data = nullptr;
+    size_t size = 0;
+};
+
+MmapFileSink::MmapFileSink(std::string path, size_t segment_bytes, size_t max_segments)
+    : path_(std::move(path))
+    , segment_bytes_(std::max<size_t>(segment_bytes, 4096))
+    , max_segments_(std::max<size_t>(max_segments, 1)) {
+}
+
+MmapFileSink::~MmapFileSink() {
+    close();
+}
+
+bool MmapFileSink::open() {
+    if (is_open()) {
+        return true;
+    }
+
+    // 保留上次运行留下的日志
+    if (FILE* existing = std::fopen(path_.c_str(), "rb")) {
+        std::fseek(existing, 0, SEEK_END);
+        const long size = std::ftell(existing);
+        std::fclose(existing);
+        if (size > 0) {
+            rotate_files();
+        }
+    }
+    return open_segment();
+}
+
+bool MmapFileSink::is_open() const {
+    return mapping_ && mapping_->data;
+}
+
+bool MmapFileSink::write(std::string_view data) {
+    while (!data.empty()) {
+        if (!is_open()) {
+            return false;
+        }
+
+        size_t n = std::min(data.size(), mapping_->size - offset_);
+        if (n < data.size()) {
+            // 尽量在行尾处滚动，一行日志不跨两个段（单行超过整段时除外）
+            const size_t line_end = data.substr(0, n).rfind('\n');
+            if (line_end != std::string_view::npos) {
+                n = line_end + 1;
+            } else if (offset_ > 0) {
+                n = 0;
+            }
+        }
+
+        if (n == 0) {
+            close_segment();
+            rotate_files();
+            if (!open_segment()) {
+                return false;
+            }
+            continue;
+        }
+
+        std::memcpy(mapping_->data + offset_, data.data(), n);
+        offset_ += n;
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+void MmapFileSink::flush() {
+    if (!is_open() || offset_ == 0) {
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(mapping_->data, offset_);
+#else
+    msync(mapping_->data, offset_, MS_ASYNC);
+#endif
+}
+
+void MmapFileSink::close() {
+    close_segment();
+}
+
+bool MmapFileSink::open_segment() {
+    auto mapping = std::make_unique<Mapping>();
+    mapping->size = segment_bytes_;
+
+#ifdef _WIN32
+    mapping->file = CreateFileA(path_.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                                nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mapping->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(segment_bytes_);
+    mapping->mapping = CreateFileMappingA(mapping->file, nullptr, PAGE_READWRITE,
+                                          size.HighPart, size.LowPart, nullptr);
+    if (!mapping->mapping) {
+        CloseHandle(mapping->file);
+        return false;
+    }
+
+    mapping->data = static_cast<char*>(MapViewOfFile(mapping->mapping, FILE_MAP_WRITE, 0, 0, segment_bytes_));
+    if (!mapping->data) {
+        CloseHandle(mapping->mapping);
+        CloseHandle(mapping->file);
+        return false;
+    }
+#else
+    mapping->fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (mapping->fd < 0) {
+        return false;
+    }
+
+    // 预先分配磁盘空间，避免写满磁盘时在缺页处收到SIGBUS
+#ifdef __linux__
+    const bool allocated = posix_fallocate(mapping->fd, 0, static_cast<off_t>(segment_bytes_)) == 0;
+#else
+    const bool allocated = ftruncate(mapping->fd, static_cast<off_t>(segment_bytes_)) == 0;
+#endif
+    if (!allocated) {
+        ::close(mapping->fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, mapping->fd, 0);
+    if (data == MAP_FAILED) {
+        ::close(mapping->fd);
+        return false;
+    }
+    mapping->data = static_cast<char*>(data);
+#endif
+
+    mapping_ = std::move(mapping);
+    offset_ = 0;
+    return true;
+}
+
+void MmapFileSink::close_segment() {
+    if (!mapping_) {
+        return;
+    }
+
+#ifdef _WIN32
+    if (mapping_->data) {
+        UnmapViewOfFile(mapping_->data);
+    }
+    if (mapping_->mapping) {
+        CloseHandle(mapping_->mapping);
+    }
+    if (mapping_->file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(offset_);
+        SetFilePointerEx(mapping_->file, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(mapping_->file);
+        CloseHandle(mapping_->file);
+    }
+#else
+    if (mapping_->data) {
+        munmap(mapping_->data, mapping_->size);
+    }
+    if (mapping_->fd >= 0) {
+        // 去掉未写入的预分配部分
+        if (ftruncate(mapping_->fd, static_cast<off_t>(offset_)) != 0) {
+            std::perror("截断日志文件失败");
+        }
+        ::close(mapping_->fd);
+    }
+#endif
+
+    mapping_.reset();
+    offset_ = 0;
+}
+
+void MmapFileSink::rotate_files() {
+    // 只保留一段时没有历史段，直接删除当前段
+    if (max_segments_ <= 1) {
+        std::remove(path_.c_str());
+        return;
+    }
+
+    // path.(n-1)被删除，其余依次后移一位，当前段成为path.1
+    const std::string oldest = path_ + "." + std::to_string(max_segments_ - 1);
+    std::remove(oldest.c_str());
+
+    for (size_t i = max_segments_ - 1; i > 1; --i) {
+        const std::string from = path_ + "." + std::to_string(i - 1);
+        const std::string to = path_ + "." + std::to_string(i);
+        std::rename(from.c_str(), to.c_str());
+    }
+
+    const std::string first = path_ + ".1";
+    std::rename(path_.c_str(), first.c_str());
+}
+
+} // namespace KK_WS
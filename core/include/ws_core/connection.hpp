@@ -1,10 +1,14 @@
 #pragma once
 #include "ws_common/interface.hpp"
+#include "ws_common/histogram.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace KK_WS::core {
 
+class IoPool;
+
 /**
  * @brief WebSocket连接实现类（Pimpl模式）
  * 
@@ -12,7 +16,10 @@ namespace KK_WS::core {
  */
 class Connection : public IWebSocketEndpoint {
 public:
-    Connection();
+    /**
+     * @param io_pool 共享的事件循环池；为空时连接独占一个单线程事件循环
+     */
+    explicit Connection(std::shared_ptr<IoPool> io_pool = nullptr);
     ~Connection() override;
 
     // 禁止拷贝和移动
@@ -22,17 +29,44 @@ public:
     Connection& operator=(Connection&&) = delete;
 
     // IWebSocketEndpoint接口实现
-    bool connect(const ws_config& config) override;  // 修改签名
+    // 发送接口只把消息放入无锁队列，由事件循环线程分帧写出，多个线程可以同时发送
+    bool connect(const ws_config& config) override;  // 阻塞等待async_connect完成
+    void async_connect(const ws_config& config, ConnectCallback callback) override;
     void disconnect() override;
     ws_connection_state get_connection_state() const override;
     bool send_message(const ws_message& message) override;
+    bool send_message(ws_message&& message) override;
+    bool send_message(ws_message::message_type type,
+                      std::shared_ptr<const std::string> payload) override;
     void set_message_callback(MessageCallback callback) override;
+    void set_message_callback(MessageViewCallback callback) override;
     void set_state_callback(StateCallback callback) override;
     void set_error_callback(ErrorCallback callback) override;
 
-    // 配置方法
+    /**
+     * @brief 批量发送：所有消息编码进同一块缓冲区，交给socket一次写出
+     *
+     * 需要压缩的消息仍由websocketpp逐条压缩，批内顺序保持不变。
+     */
+    bool send_batch(std::vector<ws_message>&& messages);
+
+    // 配置方法：在事件循环线程上执行，可以从任意线程调用（会等待事件循环）
     void set_config(const ws_config& config);
-    const ws_config& get_config() const;
+    ws_config get_config() const;
+
+    /**
+     * @brief 心跳往返时间统计（微秒），每次收到对应的pong时记录
+     */
+    HistogramSnapshot get_rtt_stats() const;
+
+    /**
+     * @brief 延迟信封统计（纳秒），需要ws_config::latency_envelope
+     *
+     * 往返延迟：本连接发出的信封被原样送回（如回显）；
+     * 单向延迟：对端发出的信封，只有两端在同一主机上时才有意义。
+     */
+    HistogramSnapshot get_round_trip_latency_stats() const;
+    HistogramSnapshot get_one_way_latency_stats() const;
 
 private:
     class ConnectionImpl;
@@ -41,7 +75,9 @@ private:
 
 /**
  * @brief 创建WebSocket连接的工厂函数
+ * @param io_pool 共享的事件循环池，多个连接复用少量线程；为空时每个连接独占一个线程
  */
-std::unique_ptr<IWebSocketEndpoint> create_connection(const ws_config& config);
+std::unique_ptr<Connection> create_connection(const ws_config& config,
+                                              std::shared_ptr<IoPool> io_pool = nullptr);
 
 } // namespace KK_WS::core
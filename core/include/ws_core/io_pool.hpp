@@ -0,0 +1,69 @@
+#pragma once
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_service.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace KK_WS::core {
+
+/**
+ * @brief 固定大小的事件循环池
+ *
+ * 池中每个事件循环是一个io_service加一个线程。多个Connection通过
+ * create_connection()共享同一个池，按轮询方式分配到各个事件循环上，
+ * 大量连接只占用少量线程。每个事件循环只有一个线程，同一连接的回调
+ * 天然串行执行。
+ *
+ * 池必须比使用它的连接活得更久（Connection持有池的shared_ptr）。
+ */
+class IoPool {
+public:
+    /**
+     * @brief 创建并启动事件循环
+     * @param threads 事件循环数量，0表示使用硬件并发数
+     */
+    explicit IoPool(size_t threads = 0);
+
+    /**
+     * @brief 停止并等待所有事件循环线程退出
+     *
+     * 正在执行的任务会执行完；已投递但尚未开始执行的任务被丢弃，不会再执行。
+     * 需要处理完全部任务的调用方应在析构前自行等待队列排空。
+     */
+    ~IoPool();
+
+    // 禁止拷贝和移动
+    IoPool(const IoPool&) = delete;
+    IoPool& operator=(const IoPool&) = delete;
+
+    /**
+     * @brief 轮询选取一个事件循环
+     */
+    boost::asio::io_service& next();
+
+    /**
+     * @brief 按下标取事件循环（对size()取模），同一下标总是得到同一个事件循环
+     */
+    boost::asio::io_service& at(size_t index) { return loops_[index % loops_.size()]->io_service; }
+
+    /**
+     * @brief 事件循环数量
+     */
+    size_t size() const { return loops_.size(); }
+
+private:
+    struct Loop {
+        boost::asio::io_service io_service;
+        boost::asio::executor_work_guard<boost::asio::io_service::executor_type> work;
+        std::thread thread;
+
+        Loop() : work(io_service.get_executor()) {}
+    };
+
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::atomic<size_t> next_{0};
+};
+
+} // namespace KK_WS::core
@@ -0,0 +1,297 @@
+#pragma once
+#include "ws_common/interface.hpp"
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#include <websocketpp/http/constants.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace KK_WS::core::deflate {
+
+/**
+ * @brief permessage-deflate (RFC 7692) 扩展
+ *
+ * 作为websocketpp配置中的permessage_deflate_type使用。websocketpp自带的
+ * enabled<>扩展无法设置压缩级别，且只能在编译期配置。websocketpp在连接的
+ * I/O线程上创建协议处理器时默认构造扩展，无法传参，因此由调用方在此之前
+ * 通过bind_to_thread()把该连接的参数绑定到这个线程上，构造时复制一份，之后不再读取。
+ *
+ * 协商规则：
+ * - 对端请求或本端配置了 *_no_context_takeover 时，对应一方每条消息后重置压缩上下文
+ * - *_max_window_bits 取双方要求的较小值。zlib的原始deflate不支持8位窗口（会按9位压缩），
+ *   本端压缩方向最少按9位提议和应答；对端要求本端压缩使用8位时拒绝协商（RFC 7692 §7.1.2），
+ *   保证通告的窗口与实际使用的一致
+ * - 解压窗口固定为15位，可以解开任意窗口大小的压缩数据
+ */
+template <typename Role>
+class extension {
+public:
+    using err_str_pair = std::pair<websocketpp::lib::error_code, std::string>;
+
+    /**
+     * @brief 指定当前线程上之后构造的扩展实例使用的压缩参数
+     *
+     * 参数按连接或按endpoint传入，不同服务器/客户端之间互不影响：
+     * - 服务器：每个I/O线程在运行endpoint之前绑定（I/O线程只属于一个服务器，
+     *   握手请求读完后在该线程上创建处理器）
+     * - 客户端：在连接的tcp_post_init回调中绑定，websocketpp随后在同一次调用中
+     *   创建处理器并生成握手提议，中间不会执行其他连接的回调
+     * 未绑定过的线程上构造的扩展不启用压缩。
+     */
+    static void bind_to_thread(const ws_compression_config& config) {
+        thread_settings() = config;
+    }
+
+    extension() : config_(thread_settings()) {
+        uint8_t& own_bits = Role::is_server ? config_.server_max_window_bits : config_.client_max_window_bits;
+        own_bits = std::max<uint8_t>(own_bits, kMinDeflateWindowBits);
+    }
+
+    ~extension() {
+        if (initialized_) {
+            deflateEnd(&dstate_);
+            inflateEnd(&istate_);
+        }
+    }
+
+    extension(const extension&) = delete;
+    extension& operator=(const extension&) = delete;
+
+    bool is_implemented() const { return config_.enabled; }
+    bool is_enabled() const { return enabled_; }
+
+    /**
+     * @brief 客户端握手请求中的扩展提议
+     */
+    std::string generate_offer() const {
+        if (!config_.enabled) {
+            return std::string();
+        }
+
+        std::string offer = "permessage-deflate";
+        if (config_.server_no_context_takeover) {
+            offer += "; server_no_context_takeover";
+        }
+        if (config_.client_no_context_takeover) {
+            offer += "; client_no_context_takeover";
+        }
+        if (config_.server_max_window_bits < 15) {
+            offer += "; server_max_window_bits=" + std::to_string(config_.server_max_window_bits);
+        }
+        offer += "; client_max_window_bits";
+        if (config_.client_max_window_bits < 15) {
+            offer += "=" + std::to_string(config_.client_max_window_bits);
+        }
+        return offer;
+    }
+
+    websocketpp::lib::error_code validate_offer(websocketpp::http::attribute_list const&) {
+        return websocketpp::lib::error_code();
+    }
+
+    /**
+     * @brief 处理对端的扩展参数
+     *
+     * 服务器端传入客户端的提议并返回应答字符串；客户端传入服务器的应答，
+     * 返回值被忽略。init()随后根据角色选择压缩方向使用的参数。
+     */
+    err_str_pair negotiate(websocketpp::http::attribute_list const& attributes) {
+        namespace pmd_error = websocketpp::extensions::permessage_deflate::error;
+
+        if (!config_.enabled) {
+            return {pmd_error::make_error_code(pmd_error::general), std::string()};
+        }
+
+        bool client_window_offered = false;
+        uint8_t server_bits = config_.server_max_window_bits;
+        uint8_t client_bits = config_.client_max_window_bits;
+        server_no_context_takeover_ = config_.server_no_context_takeover;
+        client_no_context_takeover_ = config_.client_no_context_takeover;
+
+        for (const auto& attr : attributes) {
+            if (attr.first == "server_no_context_takeover") {
+                server_no_context_takeover_ = true;
+            } else if (attr.first == "client_no_context_takeover") {
+                client_no_context_takeover_ = true;
+            } else if (attr.first == "server_max_window_bits") {
+                uint8_t bits;
+                if (!parse_window_bits(attr.second, bits)) {
+                    return {pmd_error::make_error_code(pmd_error::invalid_max_window_bits), std::string()};
+                }
+                server_bits = std::min(server_bits, bits);
+            } else if (attr.first == "client_max_window_bits") {
+                client_window_offered = true;
+                if (!attr.second.empty()) {
+                    uint8_t bits;
+                    if (!parse_window_bits(attr.second, bits)) {
+                        return {pmd_error::make_error_code(pmd_error::invalid_max_window_bits), std::string()};
+                    }
+                    client_bits = std::min(client_bits, bits);
+                }
+            } else {
+                return {pmd_error::make_error_code(pmd_error::unsupported_attributes), std::string()};
+            }
+        }
+
+        // 对端要求本端压缩使用的窗口小于zlib能产生的最小窗口，无法遵守，拒绝该提议/应答
+        if ((Role::is_server ? server_bits : client_bits) < kMinDeflateWindowBits) {
+            return {pmd_error::make_error_code(pmd_error::invalid_max_window_bits), std::string()};
+        }
+
+        server_max_window_bits_ = server_bits;
+        client_max_window_bits_ = client_bits;
+
+        std::string response = "permessage-deflate";
+        if (server_no_context_takeover_) {
+            response += "; server_no_context_takeover";
+        }
+        if (client_no_context_takeover_) {
+            response += "; client_no_context_takeover";
+        }
+        if (server_max_window_bits_ < 15) {
+            response += "; server_max_window_bits=" + std::to_string(server_max_window_bits_);
+        }
+        if (client_window_offered && client_max_window_bits_ < 15) {
+            response += "; client_max_window_bits=" + std::to_string(client_max_window_bits_);
+        }
+        return {websocketpp::lib::error_code(), response};
+    }
+
+    /**
+     * @brief 协商完成后初始化zlib状态
+     */
+    websocketpp::lib::error_code init(bool is_server) {
+        namespace pmd_error = websocketpp::extensions::permessage_deflate::error;
+
+        const uint8_t deflate_bits = is_server ? server_max_window_bits_ : client_max_window_bits_;
+        reset_after_message_ = is_server ? server_no_context_takeover_ : client_no_context_takeover_;
+
+        dstate_.zalloc = Z_NULL;
+        dstate_.zfree = Z_NULL;
+        dstate_.opaque = Z_NULL;
+        if (deflateInit2(&dstate_, config_.level, Z_DEFLATED, -deflate_bits, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            return pmd_error::make_error_code(pmd_error::zlib_error);
+        }
+
+        istate_.zalloc = Z_NULL;
+        istate_.zfree = Z_NULL;
+        istate_.opaque = Z_NULL;
+        istate_.avail_in = 0;
+        istate_.next_in = Z_NULL;
+        if (inflateInit2(&istate_, -15) != Z_OK) {
+            deflateEnd(&dstate_);
+            return pmd_error::make_error_code(pmd_error::zlib_error);
+        }
+
+        initialized_ = true;
+        enabled_ = true;
+        return websocketpp::lib::error_code();
+    }
+
+    /**
+     * @brief 压缩一条完整消息（同步刷新）
+     *
+     * 与websocketpp的enabled<>扩展约定一致：输出保留 00 00 FF FF 尾部，
+     * 由hybi13::prepare_data_frame在分帧时去掉。
+     */
+    websocketpp::lib::error_code compress(std::string const& in, std::string& out) {
+        namespace pmd_error = websocketpp::extensions::permessage_deflate::error;
+        if (!enabled_) {
+            return pmd_error::make_error_code(pmd_error::uninitialized);
+        }
+
+        dstate_.avail_in = static_cast<uInt>(in.size());
+        dstate_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+
+        do {
+            dstate_.avail_out = kChunkSize;
+            dstate_.next_out = buffer_;
+            if (::deflate(&dstate_, Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+                return pmd_error::make_error_code(pmd_error::zlib_error);
+            }
+            out.append(reinterpret_cast<char*>(buffer_), kChunkSize - dstate_.avail_out);
+        } while (dstate_.avail_out == 0);
+
+        if (reset_after_message_) {
+            deflateReset(&dstate_);
+        }
+        return websocketpp::lib::error_code();
+    }
+
+    /**
+     * @brief 解压数据块（消息结束时websocketpp会追加 00 00 FF FF 尾部）
+     */
+    websocketpp::lib::error_code decompress(uint8_t const* buf, size_t len, std::string& out) {
+        namespace pmd_error = websocketpp::extensions::permessage_deflate::error;
+        if (!enabled_) {
+            return pmd_error::make_error_code(pmd_error::uninitialized);
+        }
+
+        istate_.avail_in = static_cast<uInt>(len);
+        istate_.next_in = const_cast<Bytef*>(buf);
+
+        do {
+            istate_.avail_out = kChunkSize;
+            istate_.next_out = buffer_;
+            const int ret = inflate(&istate_, Z_SYNC_FLUSH);
+            if (ret != Z_OK && ret != Z_BUF_ERROR && ret != Z_STREAM_END) {
+                return pmd_error::make_error_code(pmd_error::zlib_error);
+            }
+            out.append(reinterpret_cast<char*>(buffer_), kChunkSize - istate_.avail_out);
+            if (ret == Z_STREAM_END) {
+                inflateReset(&istate_);
+            }
+        } while (istate_.avail_out == 0);
+
+        return websocketpp::lib::error_code();
+    }
+
+private:
+    static constexpr size_t kChunkSize = 16384;
+    static constexpr uint8_t kMinDeflateWindowBits = 9;
+
+    static bool parse_window_bits(const std::string& value, uint8_t& bits) {
+        if (value.empty() || value.size() > 2 ||
+            !std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return false;
+        }
+        const int parsed = std::stoi(value);
+        if (parsed < 8 || parsed > 15) {
+            return false;
+        }
+        bits = static_cast<uint8_t>(parsed);
+        return true;
+    }
+
+    static ws_compression_config& thread_settings() {
+        static thread_local ws_compression_config config;
+        return config;
+    }
+
+private:
+    ws_compression_config config_;
+
+    bool enabled_ = false;
+    bool initialized_ = false;
+    bool server_no_context_takeover_ = false;
+    bool client_no_context_takeover_ = false;
+    bool reset_after_message_ = false;
+    uint8_t server_max_window_bits_ = 15;
+    uint8_t client_max_window_bits_ = 15;
+
+    z_stream dstate_{};
+    z_stream istate_{};
+    unsigned char buffer_[kChunkSize];
+};
+
+// 角色标签：服务器和客户端的扩展是不同的类型，线程上的绑定各自独立
+struct server_role {
+    static constexpr bool is_server = true;
+};
+struct client_role {
+    static constexpr bool is_server = false;
+};
+
+} // namespace KK_WS::core::deflate
@@ -1,30 +1,96 @@
 #include "ws_core/connection.hpp"
+#include "ws_core/permessage_deflate.hpp"
+#include "ws_core/io_pool.hpp"
 #include "ws_common/logger.hpp"
+#include "ws_common/histogram.hpp"
+#include "ws_common/latency_envelope.hpp"
+#include "ws_common/metrics.hpp"
+#include "ws_common/mpsc_queue.hpp"
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/client.hpp>
 #include <websocketpp/server.hpp>
-#include <thread>
+#include <websocketpp/processors/hybi13.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <random>
+#include <variant>
 
 namespace KK_WS::core {
 
-using client_t = websocketpp::client<websocketpp::config::asio>;
+/**
+ * @brief 客户端使用的websocketpp配置（启用permessage-deflate扩展）
+ */
+struct client_config : public websocketpp::config::asio {
+    typedef deflate::extension<deflate::client_role> permessage_deflate_type;
+};
+
+using client_t = websocketpp::client<client_config>;
 using connection_hdl = websocketpp::connection_hdl;
 
+/**
+ * @brief 所有客户端连接共用的进程级指标，注册在MetricsRegistry::global()中
+ */
+struct ClientMetrics {
+    MetricsRegistry& registry = MetricsRegistry::global();
+
+    Gauge& connections = registry.gauge(
+        "ws_client_connections", "当前已建立的客户端连接数");
+    Counter& reconnects = registry.counter(
+        "ws_client_reconnects_total", "自动重连尝试次数");
+    Counter& messages_sent = registry.counter(
+        "ws_client_messages_sent_total", "已交给socket写出的消息数");
+    Counter& bytes_sent = registry.counter(
+        "ws_client_sent_bytes_total", "已交给socket写出的消息负载字节数");
+    Counter& send_errors = registry.counter(
+        "ws_client_send_errors_total", "写出失败的发送批次数");
+    Counter& messages_received = registry.counter(
+        "ws_client_messages_received_total", "收到的消息数");
+    Counter& bytes_received = registry.counter(
+        "ws_client_received_bytes_total", "收到的消息负载字节数");
+    Histogram& ping_rtt = registry.histogram(
+        "ws_client_ping_rtt_seconds", "心跳往返时间", 1e-6);
+    Histogram& round_trip_latency = registry.histogram(
+        "ws_client_round_trip_latency_seconds", "带延迟信封的消息从发送到收到回显的时间", 1e-9);
+    Histogram& one_way_latency = registry.histogram(
+        "ws_client_one_way_latency_seconds", "带延迟信封的消息从对端发送到本端收到的时间（仅同一主机有意义）", 1e-9);
+
+    static ClientMetrics& instance() {
+        static ClientMetrics metrics;
+        return metrics;
+    }
+};
+
 /**
  * @brief Connection的私有实现类（Pimpl模式）
  */
 class Connection::ConnectionImpl {
 public:
-    ConnectionImpl() 
-        : state_(ws_connection_state::WS_DISCONNECTED)
+    explicit ConnectionImpl(std::shared_ptr<IoPool> io_pool)
+        : io_pool_(io_pool ? std::move(io_pool) : std::make_shared<IoPool>(1))
+        , io_service_(io_pool_->next())
+        , frame_msg_manager_(std::make_shared<client_config::con_msg_manager_type>())
+        , frame_processor_(false, false, frame_msg_manager_, frame_rng_)
+        , reconnect_timer_(io_service_)
+        , lifetime_(std::make_shared<char>())
+        , lifetime_guard_(lifetime_)
+        , random_(std::random_device{}())
+        , ping_timer_(io_service_)
+        , envelope_origin_(static_cast<uint32_t>(random_()))
+        , state_(ws_connection_state::WS_DISCONNECTED)
         , reconnect_attempts_(0) {
         
         // 初始化WebSocket客户端
         client_.clear_access_channels(websocketpp::log::alevel::all);
         client_.clear_error_channels(websocketpp::log::elevel::all);
         
-        client_.init_asio();
+        // 运行在池中的事件循环上，endpoint不拥有io_service
+        client_.init_asio(&io_service_);
         
         // 设置事件处理器
         client_.set_open_handler([this](connection_hdl hdl) {
@@ -42,65 +108,55 @@ public:
         client_.set_message_handler([this](connection_hdl hdl, client_t::message_ptr msg) {
             on_message(hdl, msg);
         });
+
+        client_.set_pong_handler([this](connection_hdl hdl, std::string payload) {
+            on_pong(hdl, payload);
+        });
+
+        client_.set_pong_timeout_handler([this](connection_hdl hdl, std::string payload) {
+            on_pong_timeout(hdl, payload);
+        });
     }
 
     ~ConnectionImpl() {
         disconnect();
-    }
+        detach_handlers();
 
-    bool connect(const ws_config& config) {
-        if (state_ == ws_connection_state::WS_CONNECTED || 
-            state_ == ws_connection_state::WS_CONNECTING) {
-            Logger::warning("已经连接或正在连接中");
-            return false;
+        // 连接尚未完成就被销毁：让等待者得到失败结果
+        if (auto callback = take_connect_callback()) {
+            callback(false, "连接已销毁");
         }
+    }
 
-        if (!config_.validate()) {
-            Logger::error("WebSocket配置无效");
-            notify_error("配置无效");
+    bool connect(const ws_config& config) {
+        // 在事件循环线程上等待会阻塞握手本身，只发起连接
+        if (on_loop_thread()) {
+            Logger::warning("在事件循环线程上调用connect()，只发起连接、不等待结果，应改用async_connect()");
+            async_connect(config, nullptr);
             return false;
         }
 
-        try {
-            state_ = ws_connection_state::WS_CONNECTING;
-            notify_state_change(state_);
-            
-            websocketpp::lib::error_code ec;
-            client_t::connection_ptr con = client_.get_connection(config_.uri, ec);
-            
-            if (ec) {
-                Logger::error("创建连接失败: " + ec.message());
-                state_ = ws_connection_state::WS_FAILED;
-                notify_error(ec.message());
-                return false;
-            }
+        std::promise<bool> result;
+        auto connected = result.get_future();
+        async_connect(config, [&result](bool success, const std::string&) {
+            result.set_value(success);
+        });
+        // 超时由websocketpp的asio定时器保证，回调一定会被调用
+        return connected.get();
+    }
 
-            hdl_ = con->get_handle();
-            client_.connect(con);
-            
-            // 在新线程中运行事件循环
-            if (!io_thread_.joinable()) {
-                io_thread_ = std::thread([this]() {
-                    try {
-                        client_.run();
-                    } catch (const std::exception& e) {
-                        Logger::error("IO线程异常: " + std::string(e.what()));
-                    }
-                });
-            }
-            
-            Logger::info("正在连接到: " + config_.uri);
-            return (state_ == ws_connection_state::WS_CONNECTED);
-            
-        } catch (const std::exception& e) {
-            Logger::error("连接异常: " + std::string(e.what()));
-            state_ = ws_connection_state::WS_FAILED;
-            notify_error(e.what());
-            return false;
-        }
+    void async_connect(const ws_config& config, ConnectCallback callback) {
+        // config_和重连状态只在事件循环线程上访问：与已触发的重连定时器串行执行，
+        // 不会同时存在两个由open_connection()创建的websocketpp连接
+        run_on_loop([this, &config, &callback]() {
+            start_connect(config, std::move(callback));
+        });
     }
 
     void disconnect() {
+        // 主动断开后不再自动重连
+        stop_reconnect();
+
         if (state_ == ws_connection_state::WS_DISCONNECTED) {
             return;
         }
@@ -109,17 +165,19 @@ public:
         notify_state_change(state_);
 
         try {
+            // 已入队的消息先交给websocketpp，关闭帧排在它们之后
+            run_on_loop([this]() {
+                drain_outbound();
+            });
+
             websocketpp::lib::error_code ec;
-            client_.close(hdl_, websocketpp::close::status::normal, "断开连接", ec);
+            client_.close(current_handle(), websocketpp::close::status::normal, "断开连接", ec);
             
             if (ec) {
                 Logger::error("关闭连接失败: " + ec.message());
-            }
-            
-            client_.stop();
-            
-            if (io_thread_.joinable()) {
-                io_thread_.join();
+            } else {
+                // 事件循环由其他连接共享，不能stop()；只等待本连接的关闭握手完成
+                wait_for_close();
             }
             
             state_ = ws_connection_state::WS_DISCONNECTED;
@@ -134,86 +192,684 @@ public:
         return state_;
     }
 
-    bool  send_message(const ws_message& message) {
+    bool send_message(const ws_message& message) {
+        return enqueue(ws_message(message));
+    }
+
+    bool send_message(ws_message&& message) {
+        return enqueue(std::move(message));
+    }
+
+    bool send_message(ws_message::message_type type, std::shared_ptr<const std::string> payload) {
+        if (!payload) {
+            return false;
+        }
+        // 客户端帧必须加掩码，共享缓冲区不能就地修改，只拷贝这一次
+        return enqueue(ws_message(type, *payload, 0));
+    }
+
+    bool send_batch(std::vector<ws_message>&& messages) {
+        return enqueue(std::move(messages));
+    }
+
+    // config_只在事件循环线程上读写，两者都在循环上执行，get_config()返回副本
+    void set_config(const ws_config& config) {
+        run_on_loop([this, &config]() {
+            config_ = config;
+            latency_envelope_.store(config.latency_envelope, std::memory_order_relaxed);
+        });
+    }
+
+    ws_config get_config() const {
+        ws_config config;
+        run_on_loop([this, &config]() {
+            config = config_;
+        });
+        return config;
+    }
+
+    HistogramSnapshot get_rtt_stats() const {
+        return rtt_histogram_.snapshot();
+    }
+
+    HistogramSnapshot get_round_trip_latency_stats() const {
+        return round_trip_latency_.snapshot();
+    }
+
+    HistogramSnapshot get_one_way_latency_stats() const {
+        return one_way_latency_.snapshot();
+    }
+
+    void set_message_callback(MessageCallback cb) {
+        message_callback_ = cb;
+    }
+
+    void set_message_view_callback(MessageViewCallback cb) {
+        message_view_callback_ = cb;
+    }
+
+    void set_state_callback(StateCallback cb) {
+        state_callback_ = cb;
+    }
+
+    void set_error_callback(ErrorCallback cb) {
+        error_callback_ = cb;
+    }
+
+private:
+    // 发送队列中的一项：单条消息，或send_batch提交的一批消息
+    using OutboundItem = std::variant<ws_message, std::vector<ws_message>>;
+
+    /**
+     * @brief 生产者线程只入队，由事件循环线程统一分帧发送
+     *
+     * 入队完成后才抢占drain_scheduled_，保证每个元素都会被某次drain_outbound()取到。
+     */
+    bool enqueue(OutboundItem item) {
         if (state_ != ws_connection_state::WS_CONNECTED) {
             Logger::warning("未连接，无法发送消息");
             return false;
         }
 
-        try {
-            websocketpp::lib::error_code ec;
-            
-            auto opcode = (message.type == ws_message::message_type::TEXT) 
-                ? websocketpp::frame::opcode::text 
+        if (auto* message = std::get_if<ws_message>(&item)) {
+            stamp(*message);
+        } else {
+            for (auto& message : std::get<std::vector<ws_message>>(item)) {
+                stamp(message);
+            }
+        }
+
+        outbound_.push(std::move(item));
+        schedule_drain();
+        return true;
+    }
+
+    // 在调用发送的线程上记录发送时刻（调用方已设置时保留）；启用延迟信封时写入负载头部
+    void stamp(ws_message& message) const {
+        if (message.time_stamp == 0) {
+            message.time_stamp = monotonic_now_ns();
+        }
+        if (latency_envelope_.load(std::memory_order_relaxed) &&
+            (message.type == ws_message::message_type::TEXT ||
+             message.type == ws_message::message_type::BINARY)) {
+            latency_envelope::prepend(message.payload, {message.time_stamp, envelope_origin_});
+        }
+    }
+
+    void schedule_drain() {
+        if (drain_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        boost::asio::post(io_service_, [this, guard = lifetime_guard_]() {
+            // guard在事件循环线程上被重置，与本回调不存在竞争
+            if (guard.expired()) {
+                return;
+            }
+            drain_outbound();
+        });
+    }
+
+    // 只在事件循环线程上调用
+    void drain_outbound() {
+        // 先清除标志再取元素：之后完成入队的生产者会重新投递一次
+        drain_scheduled_.exchange(false, std::memory_order_acq_rel);
+
+        websocketpp::lib::error_code ec;
+        client_t::connection_ptr con = client_.get_con_from_hdl(current_handle(), ec);
+
+        size_t drained = 0;
+        while (drained < kMaxDrainPerRun) {
+            std::optional<OutboundItem> item = outbound_.pop();
+            if (!item) {
+                break;
+            }
+            ++drained;
+
+            // 连接已不可写时丢弃剩余消息，只报告一次错误
+            if (ec) {
+                continue;
+            }
+            try {
+                size_t count = 1;
+                size_t bytes = 0;
+                if (auto* message = std::get_if<ws_message>(&*item)) {
+                    bytes = message->payload.size();
+                    ec = write_message(con, std::move(*message));
+                } else {
+                    auto& batch = std::get<std::vector<ws_message>>(*item);
+                    count = batch.size();
+                    for (const auto& message : batch) {
+                        bytes += message.payload.size();
+                    }
+                    ec = write_batch(con, batch);
+                }
+                if (!ec) {
+                    metrics_.messages_sent.add(count);
+                    metrics_.bytes_sent.add(bytes);
+                }
+            } catch (const std::exception& e) {
+                Logger::error("发送消息异常: " + std::string(e.what()));
+                ec = websocketpp::error::make_error_code(websocketpp::error::general);
+            }
+        }
+
+        if (ec) {
+            metrics_.send_errors.add();
+            Logger::error("发送消息失败: " + ec.message());
+            notify_error(ec.message());
+        }
+
+        // 单次最多处理kMaxDrainPerRun项，避免持续的生产者饿死同一事件循环上的其他连接
+        if (drained == kMaxDrainPerRun) {
+            schedule_drain();
+        }
+    }
+
+    /**
+     * @brief 将单条消息放入websocketpp消息并发送
+     *
+     * 负载直接移入消息缓冲区；不压缩的消息在该缓冲区上就地加掩码并写入帧头，
+     * websocketpp遇到prepared消息直接入队，不再为输出帧分配和拷贝负载。
+     * 同一次drain中依次交出的帧由websocketpp合并为一次gather写。
+     */
+    websocketpp::lib::error_code write_message(const client_t::connection_ptr& con, ws_message&& message) {
+        auto opcode = (message.type == ws_message::message_type::TEXT)
+            ? websocketpp::frame::opcode::text
+            : websocketpp::frame::opcode::binary;
+
+        const size_t size = message.payload.size();
+        client_t::message_ptr msg = con->get_message(opcode, 0);
+        msg->get_raw_payload() = std::move(message.payload);
+
+        websocketpp::lib::error_code ec;
+        if (config_.compression.enabled && size >= config_.compression.min_size) {
+            // 压缩依赖连接自己的压缩上下文，交给websocketpp分帧
+            msg->set_compressed(true);
+        } else {
+            ec = frame_processor_.prepare_data_frame(msg, msg);
+        }
+        if (!ec) {
+            ec = con->send(msg);
+        }
+        return ec;
+    }
+
+    /**
+     * @brief 将一批消息编码进同一块缓冲区，作为一个prepared消息发送
+     *
+     * 需要压缩的消息仍由websocketpp逐条压缩，之前先送出已拼接的部分以保持顺序。
+     */
+    websocketpp::lib::error_code write_batch(const client_t::connection_ptr& con,
+                                             std::vector<ws_message>& messages) {
+        websocketpp::lib::error_code ec;
+        std::string batch;
+
+        size_t total = 0;
+        for (const auto& message : messages) {
+            total += message.payload.size() + kMaxClientHeaderSize;
+        }
+        batch.reserve(total);
+
+        auto flush = [&]() {
+            if (batch.empty()) {
+                return;
+            }
+            client_t::message_ptr msg = con->get_message(websocketpp::frame::opcode::binary, 0);
+            msg->get_raw_payload() = std::move(batch);
+            msg->set_prepared(true);
+            ec = con->send(msg);
+            batch.clear();
+        };
+
+        for (auto& message : messages) {
+            auto opcode = (message.type == ws_message::message_type::TEXT)
+                ? websocketpp::frame::opcode::text
                 : websocketpp::frame::opcode::binary;
-            
-            client_.send(hdl_, message.payload, opcode, ec);
-            
+
+            if (config_.compression.enabled && message.payload.size() >= config_.compression.min_size) {
+                flush();
+                if (!ec) {
+                    ec = write_message(con, std::move(message));
+                }
+            } else if (!append_frame(batch, opcode, message.payload)) {
+                ec = websocketpp::processor::error::make_error_code(
+                    websocketpp::processor::error::invalid_payload);
+            }
+            if (ec) {
+                return ec;
+            }
+        }
+        flush();
+        return ec;
+    }
+
+    /**
+     * @brief 将一条消息编码为加掩码的客户端帧并追加到out末尾
+     * @return 文本消息不是合法UTF-8时返回false
+     */
+    bool append_frame(std::string& out, websocketpp::frame::opcode::value opcode, const std::string& payload) {
+        if (opcode == websocketpp::frame::opcode::text && !websocketpp::utf8_validator::validate(payload)) {
+            return false;
+        }
+
+        websocketpp::frame::masking_key_type key;
+        key.i = frame_rng_();
+
+        websocketpp::frame::basic_header header(opcode, payload.size(), true, true);
+        websocketpp::frame::extended_header extended(payload.size(), key.i);
+        out += websocketpp::frame::prepare_header(header, extended);
+
+        const size_t offset = out.size();
+        out += payload;
+        auto* data = reinterpret_cast<uint8_t*>(&out[offset]);
+        websocketpp::frame::word_mask_exact(data, data, payload.size(), key);
+        return true;
+    }
+
+    // async_connect()的实现，在事件循环线程上调用
+    void start_connect(const ws_config& config, ConnectCallback callback) {
+        if (state_ == ws_connection_state::WS_CONNECTED ||
+            state_ == ws_connection_state::WS_CONNECTING) {
+            Logger::warning("已经连接或正在连接中");
+            post_connect_result(std::move(callback), false, "已经连接或正在连接中");
+            return;
+        }
+
+        if (!config.validate()) {
+            Logger::error("WebSocket配置无效");
+            notify_error("配置无效");
+            post_connect_result(std::move(callback), false, "配置无效");
+            return;
+        }
+
+        // 用户主动连接，取消正在等待的自动重连
+        stop_reconnect();
+
+        try {
+            config_ = config;
+            latency_envelope_.store(config.latency_envelope, std::memory_order_relaxed);
+            reconnect_attempts_ = 0;
+            state_ = ws_connection_state::WS_CONNECTING;
+            notify_state_change(state_);
+
+            {
+                std::lock_guard<std::mutex> lock(connect_mutex_);
+                connect_callback_ = std::move(callback);
+            }
+
+            websocketpp::lib::error_code ec = open_connection();
             if (ec) {
-                Logger::error("发送消息失败: " + ec.message());
+                Logger::error("创建连接失败: " + ec.message());
+                state_ = ws_connection_state::WS_FAILED;
                 notify_error(ec.message());
-                return false;
+                post_connect_result(take_connect_callback(), false, ec.message());
+                return;
             }
-            return true;
             
         } catch (const std::exception& e) {
-            Logger::error("发送消息异常: " + std::string(e.what()));
-            return false;
+            Logger::error("连接异常: " + std::string(e.what()));
+            state_ = ws_connection_state::WS_FAILED;
+            notify_error(e.what());
+            if (!callback) {
+                callback = take_connect_callback();
+            }
+            post_connect_result(std::move(callback), false, e.what());
         }
     }
 
-    void set_config(const ws_config& config) {
-        config_ = config;
+    // 按config_创建并发起一个新的websocketpp连接（首次连接和重连共用）
+    websocketpp::lib::error_code open_connection() {
+        websocketpp::lib::error_code ec;
+        client_t::connection_ptr con = client_.get_connection(config_.uri, ec);
+        if (ec) {
+            return ec;
+        }
+
+        // TCP连接建立后websocketpp在同一次调用中创建协议处理器（含压缩扩展）并发送握手请求，
+        // 在此之前把本连接的压缩参数绑定到当前线程，共享事件循环的其他客户端互不影响
+        con->set_tcp_post_init_handler([compression = config_.compression](connection_hdl) {
+            client_config::permessage_deflate_type::bind_to_thread(compression);
+        });
+
+        // 握手超时由websocketpp在asio上计时，超时后走on_fail
+        if (config_.connect_timeout_ms > 0) {
+            con->set_open_handshake_timeout(config_.connect_timeout_ms);
+        }
+
+        // pong超时不超过心跳间隔，保证下一次ping之前已判定上一次是否丢失
+        if (config_.ping_interval_ms > 0 && config_.pong_timeout_ms > 0) {
+            con->set_pong_timeout(std::min(config_.pong_timeout_ms, config_.ping_interval_ms));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(hdl_mutex_);
+            hdl_ = con->get_handle();
+        }
+        client_.connect(con);
+
+        Logger::info("正在连接到: " + config_.uri);
+        return ec;
     }
 
-    const ws_config& get_config() const {
-        return config_;
+    connection_hdl current_handle() const {
+        std::lock_guard<std::mutex> lock(hdl_mutex_);
+        return hdl_;
     }
 
-    void set_message_callback(MessageCallback cb) {
-        message_callback_ = cb;
+    /**
+     * @brief 连接断开或重连失败后安排下一次重连（在事件循环线程上调用）
+     *
+     * 延迟采用带完全抖动的指数退避：在 [0, min(上限, 基础间隔 * 2^n)] 内均匀取值，
+     * 服务器重启时大量客户端的重连请求会被打散，而不是同时到达。
+     */
+    void schedule_reconnect() {
+        if (!reconnect_armed_ || !config_.enable_auto_reconnect) {
+            return;
+        }
+
+        if (config_.max_reconnect_attempts > 0 &&
+            reconnect_attempts_ >= config_.max_reconnect_attempts) {
+            reconnect_armed_ = false;
+            Logger::error("自动重连失败，已达到最大重连次数: " +
+                          std::to_string(config_.max_reconnect_attempts));
+            notify_error("重连次数已用尽");
+            return;
+        }
+
+        const int64_t base = std::max(1, config_.reconnect_interval_ms);
+        const int64_t cap = std::max<int64_t>(base, config_.reconnect_max_interval_ms);
+        const int shift = std::min(reconnect_attempts_, 30);
+        const int64_t ceiling = std::min(cap, base << shift);
+        const int64_t delay = std::uniform_int_distribution<int64_t>(0, ceiling)(random_);
+
+        reconnect_attempts_++;
+        Logger::info("将在 " + std::to_string(delay) + " 毫秒后进行第 " +
+                     std::to_string(reconnect_attempts_) + " 次重连");
+
+        reconnect_timer_.expires_after(std::chrono::milliseconds(delay));
+        reconnect_timer_.async_wait([this, guard = std::weak_ptr<char>(lifetime_)](
+                                        const boost::system::error_code& ec) {
+            // guard在事件循环线程上被重置，与本回调不存在竞争
+            if (ec || guard.expired() || !reconnect_armed_) {
+                return;
+            }
+            reconnect();
+        });
     }
 
-    void set_state_callback(StateCallback cb) {
-        state_callback_ = cb;
+    void reconnect() {
+        metrics_.reconnects.add();
+        state_ = ws_connection_state::WS_CONNECTING;
+        notify_state_change(state_);
+
+        try {
+            websocketpp::lib::error_code ec = open_connection();
+            if (ec) {
+                Logger::error("重连失败: " + ec.message());
+                state_ = ws_connection_state::WS_FAILED;
+                notify_state_change(state_);
+                schedule_reconnect();
+            }
+        } catch (const std::exception& e) {
+            Logger::error("重连异常: " + std::string(e.what()));
+            state_ = ws_connection_state::WS_FAILED;
+            notify_state_change(state_);
+            schedule_reconnect();
+        }
     }
 
-    void set_error_callback(ErrorCallback cb) {
-        error_callback_ = cb;
+    void stop_reconnect() {
+        reconnect_armed_ = false;
+        run_on_loop([this]() {
+            reconnect_timer_.cancel();
+        });
     }
 
-private:
     void on_open(connection_hdl hdl) {
         Logger::info("WebSocket连接已建立");
+        metrics_.connections.add();
         state_ = ws_connection_state::WS_CONNECTED;
         reconnect_attempts_ = 0;
+        // 连接成功建立过之后，意外断开才自动重连
+        reconnect_armed_ = true;
         notify_state_change(state_);
+
+        schedule_ping();
+
+        if (auto callback = take_connect_callback()) {
+            callback(true, std::string());
+        }
     }
 
     void on_close(connection_hdl hdl) {
         Logger::info("WebSocket连接已关闭");
-        state_ = ws_connection_state::WS_DISCONNECTED;
+        metrics_.connections.sub();
+        {
+            std::lock_guard<std::mutex> lock(close_mutex_);
+            state_ = ws_connection_state::WS_DISCONNECTED;
+        }
+        close_cv_.notify_all();
         notify_state_change(state_);
+
+        ping_timer_.cancel();
+        schedule_reconnect();
+    }
+
+    // ========== 心跳 ==========
+
+    void schedule_ping() {
+        if (config_.ping_interval_ms <= 0) {
+            return;
+        }
+
+        ping_timer_.expires_after(std::chrono::milliseconds(config_.ping_interval_ms));
+        ping_timer_.async_wait([this, guard = std::weak_ptr<char>(lifetime_)](
+                                   const boost::system::error_code& ec) {
+            if (ec || guard.expired()) {
+                return;
+            }
+            send_ping();
+        });
+    }
+
+    void send_ping() {
+        if (state_ != ws_connection_state::WS_CONNECTED) {
+            return;
+        }
+
+        websocketpp::lib::error_code ec;
+        client_t::connection_ptr con = client_.get_con_from_hdl(current_handle(), ec);
+        if (ec) {
+            return;
+        }
+
+        // 负载携带序号，迟到的pong不会被算作当前这次的往返时间
+        ping_sequence_++;
+        ping_sent_at_ = std::chrono::steady_clock::now();
+        con->ping(std::to_string(ping_sequence_), ec);
+        if (ec) {
+            Logger::warning("发送心跳失败: " + ec.message());
+        }
+
+        schedule_ping();
+    }
+
+    void on_pong(connection_hdl hdl, const std::string& payload) {
+        if (payload != std::to_string(ping_sequence_)) {
+            return;
+        }
+        auto rtt = std::chrono::steady_clock::now() - ping_sent_at_;
+        const auto rtt_us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(rtt).count());
+        rtt_histogram_.record(rtt_us);
+        metrics_.ping_rtt.record(rtt_us);
+    }
+
+    /**
+     * @brief pong超时：对端可能已半开，直接关闭socket，而不是等待关闭握手超时
+     *
+     * 关闭后websocketpp的读操作失败并终止连接，随后走on_close和自动重连。
+     */
+    void on_pong_timeout(connection_hdl hdl, const std::string& payload) {
+        Logger::warning("心跳超时（序号 " + payload + "），断开连接");
+        notify_error("心跳超时");
+
+        websocketpp::lib::error_code ec;
+        client_t::connection_ptr con = client_.get_con_from_hdl(hdl, ec);
+        if (ec) {
+            return;
+        }
+        boost::system::error_code socket_ec;
+        con->get_raw_socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, socket_ec);
     }
 
     void on_fail(connection_hdl hdl) {
         Logger::error("WebSocket连接失败");
-        state_ = ws_connection_state::WS_FAILED;
+        {
+            std::lock_guard<std::mutex> lock(close_mutex_);
+            state_ = ws_connection_state::WS_FAILED;
+        }
+        close_cv_.notify_all();
         notify_state_change(state_);
-        notify_error("连接失败");
+
+        websocketpp::lib::error_code ec;
+        client_t::connection_ptr con = client_.get_con_from_hdl(hdl, ec);
+        const std::string reason = con && con->get_ec() ? con->get_ec().message() : "连接失败";
+        notify_error(reason);
+
+        if (auto callback = take_connect_callback()) {
+            callback(false, reason);
+        }
+
+        // 仅当处于重连过程中时继续退避重试，首次连接失败直接报告给调用方
+        schedule_reconnect();
+    }
+
+    ConnectCallback take_connect_callback() {
+        std::lock_guard<std::mutex> lock(connect_mutex_);
+        ConnectCallback callback = std::move(connect_callback_);
+        connect_callback_ = nullptr;
+        return callback;
+    }
+
+    // 连接结果总是在事件循环上回调，调用方可以在持锁状态下发起连接
+    void post_connect_result(ConnectCallback callback, bool success, const std::string& error) {
+        if (!callback) {
+            return;
+        }
+        boost::asio::post(io_service_, [callback = std::move(callback), success, error]() {
+            callback(success, error);
+        });
+    }
+
+    bool on_loop_thread() const {
+        return io_service_.get_executor().running_in_this_thread();
+    }
+
+    // 在本连接的事件循环上执行f并等待完成（已在该线程上时直接执行）
+    template <typename F>
+    void run_on_loop(F f) const {
+        if (on_loop_thread()) {
+            f();
+            return;
+        }
+        std::promise<void> done;
+        auto finished = done.get_future();
+        boost::asio::post(io_service_, [&f, &done]() {
+            f();
+            done.set_value();
+        });
+        finished.wait();
+    }
+
+    void wait_for_close() {
+        // 在事件循环线程上（例如回调中断开）等待会阻塞关闭握手本身
+        if (on_loop_thread()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(close_mutex_);
+        close_cv_.wait_for(lock, kCloseTimeout, [this]() {
+            return state_ == ws_connection_state::WS_DISCONNECTED ||
+                   state_ == ws_connection_state::WS_FAILED;
+        });
+    }
+
+    // 析构前在事件循环上清空连接的回调，之后不会再有回调访问本对象
+    void detach_handlers() {
+        websocketpp::lib::error_code ec;
+        client_t::connection_ptr con = client_.get_con_from_hdl(current_handle(), ec);
+        run_on_loop([this, &con]() {
+            reconnect_timer_.cancel();
+            ping_timer_.cancel();
+            lifetime_.reset();
+            if (con) {
+                con->set_open_handler(nullptr);
+                con->set_close_handler(nullptr);
+                con->set_fail_handler(nullptr);
+                con->set_message_handler(nullptr);
+                con->set_pong_handler(nullptr);
+                con->set_pong_timeout_handler(nullptr);
+            }
+        });
     }
 
     void on_message(connection_hdl hdl, client_t::message_ptr msg) {
+        const uint64_t received_at = monotonic_now_ns();
+        std::string_view payload = msg->get_payload();
+
+        metrics_.messages_received.add();
+        metrics_.bytes_received.add(payload.size());
+
+        // 剥离延迟信封，回调只看到原始负载
+        if (config_.latency_envelope) {
+            if (auto stamp = latency_envelope::parse(payload)) {
+                payload.remove_prefix(latency_envelope::kSize);
+                record_latency(*stamp, received_at);
+            }
+        }
+
+        if (!message_callback_ && !message_view_callback_) {
+            return;
+        }
+
+        auto msg_type = (msg->get_opcode() == websocketpp::frame::opcode::text)
+            ? ws_message::message_type::TEXT
+            : ws_message::message_type::BINARY;
+
+        if (message_view_callback_) {
+            // 视图直接引用websocketpp的消息缓冲区，owner持有message_ptr使其不被回收
+            ws_message_view view;
+            view.type = msg_type;
+            view.payload = payload;
+            view.owner = msg;
+            view.time_stamp = received_at;
+            message_view_callback_(view);
+        }
+
         if (message_callback_) {
-            auto msg_type = (msg->get_opcode() == websocketpp::frame::opcode::text)
-                ? ws_message::message_type::TEXT
-                : ws_message::message_type::BINARY;
-            
-            ws_message ws_msg(msg_type, msg->get_payload(), 0);
+            ws_message ws_msg(msg_type, std::string(payload), received_at);
             message_callback_(ws_msg);
         }
     }
 
+    /**
+     * @brief 信封带有本连接的标识时为往返延迟，否则为对端到本端的单向延迟
+     */
+    void record_latency(const latency_envelope::Stamp& stamp, uint64_t received_at) {
+        // 不同主机的单调时钟不可比，可能出现负值
+        if (received_at < stamp.sent_ns) {
+            return;
+        }
+        const uint64_t latency = received_at - stamp.sent_ns;
+        if (stamp.origin == envelope_origin_) {
+            round_trip_latency_.record(latency);
+            metrics_.round_trip_latency.record(latency);
+        } else {
+            one_way_latency_.record(latency);
+            metrics_.one_way_latency.record(latency);
+        }
+    }
+
     void notify_state_change(ws_connection_state state) {
         if (state_callback_) {
             state_callback_(state);
@@ -227,22 +883,68 @@ private:
     }
 
 private:
+    static constexpr std::chrono::seconds kCloseTimeout{3};
+    // 客户端帧头最大长度：2字节基本头 + 8字节扩展长度 + 4字节掩码
+    static constexpr size_t kMaxClientHeaderSize = 14;
+    static constexpr size_t kMaxDrainPerRun = 1024;
+
+    // io_pool_必须先于client_构造、晚于client_析构
+    std::shared_ptr<IoPool> io_pool_;
+    boost::asio::io_service& io_service_;
     client_t client_;
-    connection_hdl hdl_;
-    std::thread io_thread_;
+
+    // 发送路径自行分帧（仅未压缩消息），只在事件循环线程上使用
+    client_config::rng_type frame_rng_;
+    client_config::con_msg_manager_type::ptr frame_msg_manager_;
+    websocketpp::processor::hybi13<client_config> frame_processor_;
+
+    // 发送队列：任意线程入队，事件循环线程取出并分帧
+    MpscQueue<OutboundItem> outbound_;
+    std::atomic<bool> drain_scheduled_{false};
+
+    mutable std::mutex hdl_mutex_;
+    connection_hdl hdl_;  // 重连时在事件循环线程上替换
+
+    // 自动重连：以下状态只在事件循环线程上访问（reconnect_armed_除外）
+    boost::asio::steady_timer reconnect_timer_;
+    std::shared_ptr<char> lifetime_;  // 定时器回调据此判断本对象是否仍然存活
+    const std::weak_ptr<char> lifetime_guard_;  // 不变的弱引用，供其他线程投递回调时捕获
+    std::mt19937_64 random_;
+    std::atomic<bool> reconnect_armed_{false};
+
+    // 心跳：定时器回调和pong回调都在事件循环线程上执行
+    boost::asio::steady_timer ping_timer_;
+    uint64_t ping_sequence_ = 0;
+    std::chrono::steady_clock::time_point ping_sent_at_;
+    LocalHistogram rtt_histogram_;  // 心跳往返时间（微秒）
+
+    // 延迟信封：本连接的标识，以及收到信封时记录的延迟（纳秒）
+    const uint32_t envelope_origin_;
+    std::atomic<bool> latency_envelope_{false};  // config_.latency_envelope的副本，发送线程读取
+    LocalHistogram round_trip_latency_;
+    LocalHistogram one_way_latency_;
+
+    ClientMetrics& metrics_ = ClientMetrics::instance();
+
+    std::mutex close_mutex_;
+    std::condition_variable close_cv_;
+
+    std::mutex connect_mutex_;
+    ConnectCallback connect_callback_;  // 进行中的连接请求，on_open/on_fail时取出
     
-    ws_config config_;
+    ws_config config_;  // 只在事件循环线程上读写
     std::atomic<ws_connection_state> state_;
-    int reconnect_attempts_;
+    int reconnect_attempts_;  // 只在事件循环线程上读写
 
     MessageCallback message_callback_;
+    MessageViewCallback message_view_callback_;
     StateCallback state_callback_;
     ErrorCallback error_callback_;
 };
 
 // Connection类的实现
-Connection::Connection() 
-    : impl_(std::make_unique<ConnectionImpl>()) {
+Connection::Connection(std::shared_ptr<IoPool> io_pool)
+    : impl_(std::make_unique<ConnectionImpl>(std::move(io_pool))) {
 }
 
 Connection::~Connection() = default;
@@ -251,6 +953,10 @@ bool Connection::connect(const ws_config& config) {
     return impl_->connect(config);
 }
 
+void Connection::async_connect(const ws_config& config, ConnectCallback callback) {
+    impl_->async_connect(config, std::move(callback));
+}
+
 void Connection::disconnect() {
     impl_->disconnect();
 }
@@ -263,10 +969,26 @@ bool Connection::send_message(const ws_message& message) {
     return impl_->send_message(message);
 }
 
+bool Connection::send_message(ws_message&& message) {
+    return impl_->send_message(std::move(message));
+}
+
+bool Connection::send_message(ws_message::message_type type, std::shared_ptr<const std::string> payload) {
+    return impl_->send_message(type, std::move(payload));
+}
+
+bool Connection::send_batch(std::vector<ws_message>&& messages) {
+    return impl_->send_batch(std::move(messages));
+}
+
 void Connection::set_message_callback(MessageCallback callback) {
     impl_->set_message_callback(callback);
 }
 
+void Connection::set_message_callback(MessageViewCallback callback) {
+    impl_->set_message_view_callback(callback);
+}
+
 void Connection::set_state_callback(StateCallback callback) {
     impl_->set_state_callback(callback);
 }
@@ -279,13 +1001,26 @@ void Connection::set_config(const ws_config& config) {
     impl_->set_config(config);
 }
 
-const ws_config& Connection::get_config() const {
+ws_config Connection::get_config() const {
     return impl_->get_config();
 }
 
+HistogramSnapshot Connection::get_rtt_stats() const {
+    return impl_->get_rtt_stats();
+}
+
+HistogramSnapshot Connection::get_round_trip_latency_stats() const {
+    return impl_->get_round_trip_latency_stats();
+}
+
+HistogramSnapshot Connection::get_one_way_latency_stats() const {
+    return impl_->get_one_way_latency_stats();
+}
+
 // 工厂函数
-std::unique_ptr<IWebSocketEndpoint> create_connection(const ws_config& config) {
-    auto conn = std::make_unique<Connection>();
+std::unique_ptr<Connection> create_connection(const ws_config& config,
+                                              std::shared_ptr<IoPool> io_pool) {
+    auto conn = std::make_unique<Connection>(std::move(io_pool));
     conn->set_config(config);
     return conn;
 }
@@ -0,0 +1,49 @@
+#include "ws_core/io_pool.hpp"
+#include "ws_common/logger.hpp"
+#include <algorithm>
+
+namespace KK_WS::core {
+
+IoPool::IoPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        loops_.push_back(std::make_unique<Loop>());
+    }
+
+    for (auto& loop : loops_) {
+        boost::asio::io_service& io_service = loop->io_service;
+        loop->thread = std::thread([&io_service]() {
+            // 单个回调抛出异常时记录并继续运行，避免整个池停摆
+            for (;;) {
+                try {
+                    io_service.run();
+                    break;
+                } catch (const std::exception& e) {
+                    Logger::error("事件循环异常: " + std::string(e.what()));
+                }
+            }
+        });
+    }
+}
+
+IoPool::~IoPool() {
+    for (auto& loop : loops_) {
+        loop->work.reset();
+        loop->io_service.stop();
+    }
+    for (auto& loop : loops_) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+    }
+}
+
+boost::asio::io_service& IoPool::next() {
+    const size_t index = next_.fetch_add(1, std::memory_order_relaxed) % loops_.size();
+    return loops_[index]->io_service;
+}
+
+} // namespace KK_WS::core
@@ -1,18 +1,111 @@
 #pragma once
 
 #include "ws_common/interface.hpp"
+#include "ws_common/metrics.hpp"
+#include "ws_core/permessage_deflate.hpp"
+#include "ws_core/io_pool.hpp"
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
 #include <memory>
-#include <set>
 #include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <optional>
+#include <string_view>
 
 namespace KK_WS::server {
 
-using server_t = websocketpp::server<websocketpp::config::asio>;
+/**
+ * @brief 连接ID（分片内slab槽位 + 代数），0表示无效
+ */
+using connection_id = uint64_t;
+constexpr connection_id invalid_connection_id = 0;
+
+/**
+ * @brief 附加在每个websocketpp连接上的服务器数据
+ *
+ * 作为config::connection_base被连接类继承，使得从connection_hdl
+ * 取得连接ID时无需额外的查找表。
+ */
+struct ConnectionData {
+    std::atomic<connection_id> server_connection_id{invalid_connection_id};
+};
+
+/**
+ * @brief 服务器使用的websocketpp配置
+ */
+struct server_config : public websocketpp::config::asio {
+    typedef ConnectionData connection_base;
+    typedef core::deflate::extension<core::deflate::server_role> permessage_deflate_type;
+};
+
+using server_t = websocketpp::server<server_config>;
 using connection_hdl = websocketpp::connection_hdl;
 using message_ptr = server_t::message_ptr;
 
+class TopicRouter;
+class FrameEncoder;
+class ConnectionRegistry;
+struct Session;
+
+/**
+ * @brief 服务器I/O线程模型
+ */
+enum class IoModel {
+    SharedIoService,    // 单个endpoint，io_threads个线程共享同一个io_service
+    ShardedReusePort    // io_threads个独立endpoint，各自通过SO_REUSEPORT监听同一端口
+};
+
+/**
+ * @brief 发送队列溢出策略
+ */
+enum class OverflowPolicy {
+    DropNewest,   // 丢弃新消息
+    DropOldest,   // 丢弃最早排队、尚未写出的消息
+    Disconnect    // 以1008 (policy violation) 关闭连接
+};
+
+/**
+ * @brief 收到数据消息后的处理方式
+ */
+enum class ForwardMode {
+    Handler,  // 交给消息处理回调；未设置回调时按Echo处理
+    Echo,     // 原样发回发送者：保留opcode，负载不拷贝，不调用消息处理回调
+    Relay     // 原样转发给其他所有连接：只生成一次帧头，所有连接共享收到的消息
+};
+
+/**
+ * @brief 接收限速超限时的处理方式
+ */
+enum class RateLimitPolicy {
+    PauseReading,  // 暂停读取该连接直到令牌恢复，由TCP流控反压对端
+    Drop           // 丢弃超限的消息，不交给消息处理回调
+};
+
+/**
+ * @brief 单个连接的接收限速统计
+ */
+struct RateLimitStats {
+    bool throttled = false;         // 当前是否因超限暂停读取
+    uint64_t throttle_events = 0;   // 超限次数（暂停读取或丢弃）
+    uint64_t dropped_messages = 0;  // Drop策略下丢弃的消息数
+    uint64_t dropped_bytes = 0;     // Drop策略下丢弃的字节数
+    uint64_t paused_ns = 0;         // 累计暂停读取的时间（纳秒）
+};
+
+/**
+ * @brief 单个连接的发送队列统计
+ */
+struct SendQueueStats {
+    size_t queued_messages = 0;     // 尚未写出的消息数（含在途）
+    size_t queued_bytes = 0;        // 尚未写出的字节数（含在途）
+    size_t inflight_messages = 0;   // 已交给socket写出的消息数
+    uint64_t dropped_messages = 0;  // 因溢出丢弃的消息数
+    uint64_t dropped_bytes = 0;     // 因溢出丢弃的字节数
+};
+
 /**
  * @brief WebSocket服务器配置
  */
@@ -20,11 +113,43 @@ struct ServerConfig {
     uint16_t port = 9002;
     bool enable_logging = true;
     std::string bind_address = "0.0.0.0";
+    IoModel io_model = IoModel::SharedIoService;
+    size_t io_threads = 1;           // 共享模式：运行io_service的线程数；分片模式：分片数（最多256）
+    bool pin_io_threads = true;      // 分片模式下将每个分片线程绑定到独立CPU核心
+
+    // 每个连接的发送队列上限（字节数与消息数任一超限即触发溢出策略）
+    size_t send_queue_max_bytes = 16 * 1024 * 1024;
+    size_t send_queue_max_messages = 4096;
+    OverflowPolicy send_queue_overflow = OverflowPolicy::DropNewest;
+
+    // permessage-deflate压缩。溢出策略会丢弃消息时，压缩上下文无法跨消息
+    // 延续（对端会缺少被丢弃的数据），此时强制server_no_context_takeover
+    ws_compression_config compression;
+
+    // 内置的回显/转发模式直接发送收到的message_ptr，用于测量传输本身的开销；
+    // 订阅控制消息仍由服务器处理
+    ForwardMode forward_mode = ForwardMode::Handler;
+
+    // 每个连接的接收限速（令牌桶），0表示不限制；桶容量为rate_limit_burst_seconds秒的额度
+    double rate_limit_messages_per_sec = 0;
+    double rate_limit_bytes_per_sec = 0;
+    double rate_limit_burst_seconds = 1.0;
+    RateLimitPolicy rate_limit_policy = RateLimitPolicy::PauseReading;
+
+    // 消息处理回调的工作线程数，0表示直接在IO线程上调用。按连接分配工作线程，
+    // 同一连接的消息按收到的顺序处理，耗时的回调不会阻塞其他连接的读写
+    size_t handler_threads = 0;
+    // 每个连接等待工作线程处理的消息上限，达到时暂停读取该连接（由TCP流控反压对端），
+    // 积压降到一半以下时恢复读取。服务器析构时尚未执行的排队消息被丢弃
+    size_t handler_queue_max_messages = 1024;
+
+    // Prometheus指标的HTTP路径，由监听端口上的websocketpp HTTP处理器直接响应；为空时不提供
+    std::string metrics_path = "/metrics";
 };
 
 /**
  * @brief WebSocket服务器类
- * 
+ *
  * 提供简单的WebSocket服务器功能，支持多客户端连接
  */
 class WebSocketServer {
@@ -41,6 +166,10 @@ public:
 
     /**
      * @brief 启动服务器
+     *
+     * 阻塞直到stop()被调用。共享模式下io_threads个线程运行同一个io_service，
+     * 同一连接的回调由websocketpp的strand串行化；分片模式下每个分片
+     * 拥有独立的endpoint和线程，由内核在分片之间分配新连接。
      */
     void start();
 
@@ -54,13 +183,74 @@ public:
      */
     void send_message(connection_hdl hdl, const std::string& message);
 
+    /**
+     * @brief 按连接ID发送消息（O(1)查找，ID过期时返回false）
+     */
+    bool send_message(connection_id id, const std::string& message);
+
+    /**
+     * @brief 向指定客户端批量发送一组消息
+     *
+     * 所有消息编码进同一块缓冲区，在发送队列中作为一个单元入队，
+     * 由websocketpp一次写出；队列溢出时整批一起丢弃。
+     * @return ID失效或整批被丢弃时返回false
+     */
+    bool send_batch(connection_id id, std::vector<ws_message>&& messages);
+    void send_batch(connection_hdl hdl, std::vector<ws_message>&& messages);
+
+    /**
+     * @brief 获取连接ID，连接已失效时返回invalid_connection_id
+     */
+    connection_id get_connection_id(connection_hdl hdl) const;
+
+    /**
+     * @brief 获取连接的发送队列深度与丢弃计数，ID失效时返回空
+     */
+    std::optional<SendQueueStats> get_send_queue_stats(connection_id id) const;
+
+    /**
+     * @brief 获取连接的接收限速统计，ID失效时返回空；未启用限速时各项为0
+     */
+    std::optional<RateLimitStats> get_rate_limit_stats(connection_id id) const;
+
+    /**
+     * @brief 当前因超限暂停读取的连接
+     */
+    std::vector<connection_id> get_throttled_connections() const;
+
     /**
      * @brief 向所有客户端广播消息
+     *
+     * 消息只编码一次，所有连接的发送队列共享同一个引用计数的帧缓冲。
+     * 协商了压缩的连接在消息达到阈值时改为逐连接压缩编码。
      */
     void broadcast(const std::string& message);
 
+    /**
+     * @brief 向订阅了topic的客户端发布消息
+     *
+     * 客户端通过 "SUBSCRIBE:<topic>" / "UNSUBSCRIBE:<topic>" 文本消息管理订阅
+     * （一条消息可携带多个以换行分隔的主题），
+     * 这两类消息由服务器直接处理，不会交给消息处理回调。
+     * @return 收到消息的订阅者数量
+     */
+    size_t publish(const std::string& topic, const std::string& payload);
+
+    /**
+     * @brief 获取主题的订阅者数量
+     */
+    size_t get_subscriber_count(const std::string& topic) const;
+
     /**
      * @brief 设置消息处理回调
+     *
+     * 配置了handler_threads时回调在工作线程上执行，回调内可以直接调用
+     * send_message()等发送接口：帧在工作线程上编码后放入连接的发送队列，
+     * 由websocketpp派发到该连接的IO线程写出，调用方无需额外加锁。
+     *
+     * 客户端启用了latency_envelope时，回调收到的是去掉延迟信封后的负载；
+     * 回调中第一次对该连接调用send_message()时服务器重新附加信封，
+     * 客户端因此能统计往返延迟（回复内容可以任意改写，例如加 "Echo: " 前缀）。
      */
     void set_message_handler(MessageHandler handler);
 
@@ -75,25 +265,65 @@ public:
     void set_close_handler(ConnectionHandler handler);
 
     /**
-     * @brief 获取当前连接数
+     * @brief 获取当前连接数（所有分片之和）
      */
     size_t get_connection_count() const;
 
+    /**
+     * @brief 服务器的指标注册表
+     *
+     * 内置连接、消息、字节、发送队列和处理回调耗时等指标，应用也可以在此注册
+     * 自己的指标，与MetricsRegistry::global()中的进程级指标一起通过metrics_path导出。
+     */
+    MetricsRegistry& metrics();
+
 private:
-    void on_open(connection_hdl hdl);
-    void on_close(connection_hdl hdl);
-    void on_message(connection_hdl hdl, message_ptr msg);
+    // 一个endpoint及其连接集合；共享模式下只有一个分片
+    struct Shard;
+    // 内置指标及其所属注册表
+    struct Metrics;
+
+    void init_shard(Shard& shard);
+    void on_open(Shard& shard, connection_hdl hdl);
+    void on_close(Shard& shard, connection_hdl hdl);
+    void on_message(Shard& shard, connection_hdl hdl, message_ptr msg);
+    // 普通HTTP请求：metrics_path返回Prometheus文本，其余返回404
+    void on_http(connection_hdl hdl);
+
+    // 所有连接发送队列统计之和（导出指标时使用）
+    SendQueueStats sum_send_queue_stats() const;
+
+    // 按ID定位所属分片并查找会话
+    std::shared_ptr<Session> find_session(connection_id id) const;
+
+    // 将已编码的共享帧放入连接的发送队列，被丢弃时返回false；message_count为帧内的消息数
+    bool send_frame(Session& session, const message_ptr& frame, size_t message_count = 1);
+
+    // 协商了压缩且消息达到阈值时为该连接单独压缩编码，否则发送共享帧
+    bool send_payload(Session& session, const std::string& payload, const message_ptr& frame,
+                      websocketpp::frame::opcode::value opcode = websocketpp::frame::opcode::text);
+
+    // ForwardMode::Echo / Relay：把收到的消息原地改为prepared帧后发送，不拷贝负载
+    bool echo_message(connection_hdl hdl, const message_ptr& msg);
+    size_t relay_message(connection_hdl hdl, const message_ptr& msg);
+
+    // 调用消息处理回调并记录耗时
+    void run_handler(const MessageHandler& handler, connection_hdl hdl, const message_ptr& msg);
+
+    // 处理订阅控制消息，返回true表示消息已被消费
+    bool handle_subscription(connection_hdl hdl, std::string_view payload);
 
 private:
     ServerConfig config_;
-    server_t endpoint_;
-    std::set<connection_hdl, std::owner_less<connection_hdl>> connections_;
-    
-    MessageHandler message_handler_;
-    ConnectionHandler open_handler_;
-    ConnectionHandler close_handler_;
-    
-    mutable std::mutex connections_mutex_;
+    std::unique_ptr<Metrics> metrics_;  // 先于分片构造、晚于分片析构
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unique_ptr<TopicRouter> topic_router_;
+    std::unique_ptr<FrameEncoder> frame_encoder_;
+    std::vector<std::thread> io_threads_;
+    std::atomic<bool> running_{false};
+    // 消息处理回调的工作线程（可选）；最后声明、最先析构，先等待执行中的回调结束，
+    // 排队中尚未执行的消息直接丢弃（连接此时已经关闭，回调无法再回复）
+    std::unique_ptr<core::IoPool> handler_pool_;
 };
 
 } // namespace KK_WS::server
@@ -0,0 +1,137 @@
+#include "connection_registry.hpp"
+
+namespace KK_WS::server {
+
+ConnectionRegistry::ConnectionRegistry(size_t shard)
+    : shard_(shard) {
+    // 不做掩码：服务器构造时已把分片数限制在kMaxShards以内，掩码只会让ID路由到错误的分片
+    for (auto& chunk : chunks_) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConnectionRegistry::~ConnectionRegistry() = default;
+
+ConnectionRegistry::Slot* ConnectionRegistry::slot_at(uint32_t index) const {
+    Slot* chunk = chunks_[index / kChunkSize].load(std::memory_order_acquire);
+    return chunk ? &chunk[index % kChunkSize] : nullptr;
+}
+
+SessionPtr ConnectionRegistry::add(SessionPtr session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint32_t index;
+    if (!free_slots_.empty()) {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        if (next_slot_ > kIndexMask) {
+            return nullptr;
+        }
+        index = next_slot_++;
+        if (index % kChunkSize == 0) {
+            owned_chunks_.push_back(std::make_unique<Slot[]>(kChunkSize));
+            chunks_[index / kChunkSize].store(owned_chunks_.back().get(), std::memory_order_release);
+        }
+    }
+
+    Slot* slot = slot_at(index);
+
+    // 代数跳过0，保证有效ID永远不等于invalid_connection_id
+    uint32_t generation = slot->generation.load(std::memory_order_relaxed) + 1;
+    if (generation == 0) {
+        generation = 1;
+    }
+
+    session->id = (static_cast<uint64_t>(generation) << kGenerationShift) |
+                  (static_cast<uint64_t>(shard_) << kShardShift) |
+                  index;
+    session->shard = shard_;
+    session->dense_index = live_.size();
+    live_.push_back(session);
+
+    std::atomic_store(&slot->session, session);
+    slot->generation.store(generation, std::memory_order_release);
+
+    count_.fetch_add(1, std::memory_order_relaxed);
+    snapshot_dirty_.store(true, std::memory_order_release);
+    return session;
+}
+
+SessionPtr ConnectionRegistry::remove(connection_id id) {
+    if (shard_of(id) != shard_) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const uint32_t index = static_cast<uint32_t>(id & kIndexMask);
+    Slot* slot = index < next_slot_ ? slot_at(index) : nullptr;
+    if (!slot) {
+        return nullptr;
+    }
+
+    SessionPtr session = std::atomic_load(&slot->session);
+    if (!session || session->id != id) {
+        return nullptr;
+    }
+
+    std::atomic_store(&slot->session, SessionPtr());
+    free_slots_.push_back(index);
+
+    // 从稠密数组中交换删除
+    const size_t pos = session->dense_index;
+    if (pos + 1 != live_.size()) {
+        live_[pos] = std::move(live_.back());
+        live_[pos]->dense_index = pos;
+    }
+    live_.pop_back();
+
+    count_.fetch_sub(1, std::memory_order_relaxed);
+    snapshot_dirty_.store(true, std::memory_order_release);
+    return session;
+}
+
+SessionPtr ConnectionRegistry::find(connection_id id) const {
+    if (id == invalid_connection_id || shard_of(id) != shard_) {
+        return nullptr;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(id & kIndexMask);
+    if (index / kChunkSize >= kMaxChunks) {
+        return nullptr;
+    }
+
+    Slot* slot = slot_at(index);
+    if (!slot) {
+        return nullptr;
+    }
+
+    // 代数不匹配时快速拒绝，再以会话自身的ID做最终确认
+    const uint32_t generation = static_cast<uint32_t>(id >> kGenerationShift);
+    if (slot->generation.load(std::memory_order_acquire) != generation) {
+        return nullptr;
+    }
+
+    SessionPtr session = std::atomic_load(&slot->session);
+    return session && session->id == id ? session : nullptr;
+}
+
+ConnectionRegistry::Snapshot ConnectionRegistry::snapshot() const {
+    if (!snapshot_dirty_.load(std::memory_order_acquire)) {
+        Snapshot current = std::atomic_load(&snapshot_);
+        if (current) {
+            return current;
+        }
+    }
+
+    // 快照过期：在写锁下重建并发布，旧快照由仍在使用它的读者释放
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (snapshot_dirty_.load(std::memory_order_acquire) || !std::atomic_load(&snapshot_)) {
+        std::atomic_store(&snapshot_, Snapshot(std::make_shared<const std::vector<SessionPtr>>(live_)));
+        snapshot_dirty_.store(false, std::memory_order_release);
+    }
+    return std::atomic_load(&snapshot_);
+}
+
+} // namespace KK_WS::server
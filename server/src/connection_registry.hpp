@@ -0,0 +1,125 @@
+#pragma once
+
+#include "ws_server/server.hpp"
+#include "outbound_queue.hpp"
+#include "frame_encoder.hpp"
+#include "read_throttle.hpp"
+#include "rate_limiter.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 服务器端每个连接的状态
+ */
+struct Session {
+    connection_id id = invalid_connection_id;
+    size_t shard = 0;
+    server_t::connection_ptr con;
+    std::shared_ptr<OutboundQueue> outbound;
+
+    // 协商了压缩时的专用编码器；压缩上下文要求编码顺序与入队顺序一致，
+    // 编码和入队都在deflate_mutex下完成
+    std::unique_ptr<FrameEncoder> deflate_encoder;
+    std::mutex deflate_mutex;
+
+    // 接收限速和处理回调积压共用的读取暂停，两者都未启用时为空
+    std::shared_ptr<ReadThrottle> read_throttle;
+    // 接收限速，未启用时为空
+    std::shared_ptr<RateLimiter> rate_limiter;
+    // 已交给工作线程、尚未处理完的消息数
+    std::atomic<size_t> handler_pending{0};
+
+    // 由ConnectionRegistry维护：在活跃连接稠密数组中的位置
+    size_t dense_index = 0;
+};
+
+using SessionPtr = std::shared_ptr<Session>;
+
+/**
+ * @brief 基于slab的连接注册表（每个分片一个）
+ *
+ * 连接存放在按块分配、地址稳定的槽位中，以紧凑的整数ID寻址：
+ *   [63..32] 代数  [31..24] 分片  [23..0] 槽位
+ * 槽位被复用时代数递增，持有过期ID的查找会直接失败。
+ *
+ * - find() 为O(1)，不加注册表锁，也不经过weak_ptr
+ * - 增删连接在写锁下进行，并将快照标记为过期
+ * - snapshot() 返回不可变的活跃连接数组（RCU风格）：读者持有快照期间
+ *   引用计数保证其存活，写者只发布新快照，从不修改已发布的快照
+ */
+class ConnectionRegistry {
+public:
+    using Snapshot = std::shared_ptr<const std::vector<SessionPtr>>;
+
+    explicit ConnectionRegistry(size_t shard);
+    ~ConnectionRegistry();
+
+    ConnectionRegistry(const ConnectionRegistry&) = delete;
+    ConnectionRegistry& operator=(const ConnectionRegistry&) = delete;
+
+    /**
+     * @brief 注册会话并为其分配ID，槽位耗尽时返回nullptr
+     */
+    SessionPtr add(SessionPtr session);
+
+    /**
+     * @brief 注销连接，返回被移除的会话（ID无效时返回nullptr）
+     */
+    SessionPtr remove(connection_id id);
+
+    /**
+     * @brief O(1)查找，ID过期或不属于本分片时返回nullptr
+     */
+    SessionPtr find(connection_id id) const;
+
+    /**
+     * @brief 获取活跃连接快照
+     */
+    Snapshot snapshot() const;
+
+    size_t size() const { return count_.load(std::memory_order_relaxed); }
+
+    static size_t shard_of(connection_id id) { return (id >> kShardShift) & kShardMask; }
+
+    // ID中分片号占8位，分片数不能超过该值
+    static constexpr size_t kMaxShards = 256;
+
+private:
+    static constexpr unsigned kShardShift = 24;
+    static constexpr uint64_t kShardMask = kMaxShards - 1;
+    static constexpr uint64_t kIndexMask = 0xFFFFFF;
+    static constexpr unsigned kGenerationShift = 32;
+
+    static constexpr size_t kChunkSize = 4096;
+    static constexpr size_t kMaxChunks = (kIndexMask + 1) / kChunkSize;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        SessionPtr session;  // 通过std::atomic_load/atomic_store访问
+    };
+
+    Slot* slot_at(uint32_t index) const;
+
+private:
+    size_t shard_;
+
+    // 块指针一经发布永不改变，查找时无需加锁
+    std::array<std::atomic<Slot*>, kMaxChunks> chunks_{};
+
+    mutable std::mutex mutex_;  // 保护以下写者状态
+    std::vector<std::unique_ptr<Slot[]>> owned_chunks_;
+    std::vector<uint32_t> free_slots_;
+    uint32_t next_slot_ = 0;
+    std::vector<SessionPtr> live_;
+
+    std::atomic<size_t> count_{0};
+    mutable std::atomic<bool> snapshot_dirty_{true};
+    mutable Snapshot snapshot_;  // 通过std::atomic_load/atomic_store访问
+};
+
+} // namespace KK_WS::server
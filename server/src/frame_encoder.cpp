@@ -0,0 +1,104 @@
+#include "frame_encoder.hpp"
+#include "ws_common/logger.hpp"
+
+namespace KK_WS::server {
+
+FrameEncoder::FrameEncoder()
+    : msg_manager_(std::make_shared<msg_manager_type>())
+    , processor_(false, true, msg_manager_, rng_) {
+}
+
+std::unique_ptr<FrameEncoder> FrameEncoder::for_compressed_connection(const server_t::connection_ptr& con) {
+    auto encoder = std::make_unique<FrameEncoder>();
+
+    auto result = encoder->processor_.negotiate_extensions(con->get_request());
+    if (result.first || result.second.empty()) {
+        return nullptr;
+    }
+    return encoder;
+}
+
+message_ptr FrameEncoder::encode(const std::string& payload,
+                                 websocketpp::frame::opcode::value opcode,
+                                 bool compress) {
+    message_ptr in = msg_manager_->get_message(opcode, payload.size());
+    message_ptr out = msg_manager_->get_message();
+    if (!in || !out) {
+        return nullptr;
+    }
+
+    in->append_payload(payload);
+    in->set_compressed(compress);
+
+    websocketpp::lib::error_code ec = processor_.prepare_data_frame(in, out);
+    if (ec) {
+        Logger::error("编码消息帧失败: " + ec.message());
+        return nullptr;
+    }
+    return out;
+}
+
+message_ptr FrameEncoder::encode_batch(const std::vector<ws_message>& messages,
+                                       FrameEncoder* compressor,
+                                       size_t min_size) {
+    // 服务器帧头最大10字节（2字节基本头 + 8字节扩展长度），不加掩码
+    size_t total = 0;
+    for (const auto& message : messages) {
+        total += message.payload.size() + 10;
+    }
+
+    message_ptr out = msg_manager_->get_message(websocketpp::frame::opcode::binary, total);
+    if (!out) {
+        return nullptr;
+    }
+    std::string& buffer = out->get_raw_payload();
+
+    for (const auto& message : messages) {
+        auto opcode = (message.type == ws_message::message_type::TEXT)
+            ? websocketpp::frame::opcode::text
+            : websocketpp::frame::opcode::binary;
+
+        if (compressor && message.payload.size() >= min_size) {
+            message_ptr frame = compressor->encode(message.payload, opcode, true);
+            if (!frame) {
+                return nullptr;
+            }
+            buffer += frame->get_header();
+            buffer += frame->get_payload();
+            continue;
+        }
+
+        if (opcode == websocketpp::frame::opcode::text &&
+            !websocketpp::utf8_validator::validate(message.payload)) {
+            Logger::error("编码消息帧失败: 文本消息不是合法的UTF-8");
+            return nullptr;
+        }
+
+        websocketpp::frame::basic_header header(opcode, message.payload.size(), true, false);
+        websocketpp::frame::extended_header extended(message.payload.size());
+        buffer += websocketpp::frame::prepare_header(header, extended);
+        buffer += message.payload;
+    }
+
+    out->set_prepared(true);
+    return out;
+}
+
+bool FrameEncoder::prepare_in_place(const message_ptr& msg) {
+    if (!msg || websocketpp::frame::opcode::is_control(msg->get_opcode())) {
+        return false;
+    }
+    if (msg->get_prepared()) {
+        return true;
+    }
+
+    const size_t size = msg->get_payload().size();
+    websocketpp::frame::basic_header header(msg->get_opcode(), size, true, false);
+    websocketpp::frame::extended_header extended(size);
+    msg->set_header(websocketpp::frame::prepare_header(header, extended));
+    msg->set_compressed(false);
+    msg->set_prepared(true);
+    return true;
+}
+
+} // namespace KK_WS::server
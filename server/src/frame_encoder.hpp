@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ws_server/server.hpp"
+#include <websocketpp/processors/hybi13.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 服务器端数据帧编码器
+ *
+ * 服务器发出的帧不加掩码，同一份已编码的帧（prepared message）可以被
+ * 任意多个连接的发送队列共享：websocketpp遇到prepared消息时直接入队，
+ * 不再逐连接重新分帧和拷贝负载。
+ *
+ * 协商了permessage-deflate的连接另外持有一个按该连接握手协商的编码器，
+ * 压缩帧依赖连接自己的压缩上下文，不能共享。
+ */
+class FrameEncoder {
+public:
+    FrameEncoder();
+
+    /**
+     * @brief 按连接的握手请求协商permessage-deflate，未启用压缩时返回nullptr
+     *
+     * 协商参数只取决于客户端提议和服务器配置，与websocketpp为该连接
+     * 协商的结果一致。返回的编码器有状态，调用方需保证同一连接串行编码。
+     */
+    static std::unique_ptr<FrameEncoder> for_compressed_connection(const server_t::connection_ptr& con);
+
+    /**
+     * @brief 将负载编码为完整的WebSocket帧，失败时返回nullptr
+     * @param compress 为true且已协商压缩时输出压缩帧（RSV1）
+     */
+    message_ptr encode(const std::string& payload,
+                       websocketpp::frame::opcode::value opcode = websocketpp::frame::opcode::text,
+                       bool compress = false);
+
+    /**
+     * @brief 将一组消息依次编码并拼接进同一个prepared message，失败时返回nullptr
+     *
+     * 交给websocketpp后整批作为一个发送单元写出。compressor非空时，达到
+     * min_size的消息用它压缩编码，调用方需持有对应连接的deflate_mutex。
+     */
+    message_ptr encode_batch(const std::vector<ws_message>& messages,
+                             FrameEncoder* compressor = nullptr,
+                             size_t min_size = 0);
+
+    /**
+     * @brief 将收到的数据消息原地改为prepared message，控制帧返回false
+     *
+     * 只生成帧头，负载不拷贝也不压缩；之后该消息不可再修改，可以被多个连接共享。
+     * 收到的文本消息已由websocketpp校验过UTF-8。
+     */
+    static bool prepare_in_place(const message_ptr& msg);
+
+private:
+    using config_type = server_config;
+    using msg_manager_type = config_type::con_msg_manager_type;
+
+    config_type::rng_type rng_;
+    msg_manager_type::ptr msg_manager_;
+    // 未协商压缩的服务器端hybi13只读取自身配置，不修改状态，可以被多个线程同时使用
+    websocketpp::processor::hybi13<config_type> processor_;
+};
+
+} // namespace KK_WS::server
@@ -2,6 +2,7 @@
 #include "ws_common/logger.hpp"
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
 #include <atomic>
 #include <thread>
 
@@ -22,8 +23,16 @@ void signal_handler(int signal) {
 }
 
 int main(int argc, char* argv[]) {
-    // 设置日志级别
+    // 设置日志级别；异步输出，日志不阻塞IO线程
     KK_WS::Logger::set_level(KK_WS::Logger::Level::Ws_INFO);
+    KK_WS::Logger::start_async();
+
+    // 设置环境变量 WS_LOG_FILE 时同时写入内存映射的滚动日志文件
+    if (const char* log_file = std::getenv("WS_LOG_FILE")) {
+        if (!KK_WS::Logger::set_file_output(log_file)) {
+            KK_WS::Logger::warningf("无法打开日志文件 {}，仅输出到控制台", log_file);
+        }
+    }
     
     KK_WS::Logger::info("===========================================");
     KK_WS::Logger::info("    WebSocket Echo Server v1.0");
@@ -40,6 +49,41 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (argc > 2) {
+        try {
+            config.io_threads = static_cast<size_t>(std::stoul(argv[2]));
+        } catch (...) {
+            KK_WS::Logger::warning("无效的IO线程数，使用单线程");
+        }
+    }
+
+    // 第三个参数为 "reuseport" 时使用SO_REUSEPORT分片模式，每个IO线程一个分片
+    if (argc > 3 && std::string(argv[3]) == "reuseport") {
+        config.io_model = KK_WS::server::IoModel::ShardedReusePort;
+    }
+
+    // 环境变量 WS_FORWARD_MODE=echo|relay 使用内置的零拷贝回显/转发，
+    // 不拼接 "Echo: " 前缀、不逐条记录日志，用于压测传输本身
+    if (const char* mode = std::getenv("WS_FORWARD_MODE")) {
+        const std::string value(mode);
+        if (value == "echo") {
+            config.forward_mode = KK_WS::server::ForwardMode::Echo;
+        } else if (value == "relay") {
+            config.forward_mode = KK_WS::server::ForwardMode::Relay;
+        } else {
+            KK_WS::Logger::warningf("未知的 WS_FORWARD_MODE: {}，使用消息处理回调", value);
+        }
+    }
+
+    // 环境变量 WS_HANDLER_THREADS 指定消息处理回调的工作线程数，回调不再占用IO线程
+    if (const char* threads = std::getenv("WS_HANDLER_THREADS")) {
+        try {
+            config.handler_threads = static_cast<size_t>(std::stoul(threads));
+        } catch (...) {
+            KK_WS::Logger::warning("无效的 WS_HANDLER_THREADS，在IO线程上处理消息");
+        }
+    }
+
     try {
         // 创建服务器
         KK_WS::server::WebSocketServer server(config);
@@ -49,9 +93,9 @@ int main(int argc, char* argv[]) {
         std::signal(SIGINT, signal_handler);
         std::signal(SIGTERM, signal_handler);
 
-        // 设置消息处理器（Echo模式）
+        // 设置消息处理器（Echo模式）；内置回显/转发模式下不会调用
         server.set_message_handler([&server](auto hdl, const std::string& message) {
-            KK_WS::Logger::info("收到消息: " + message);
+            KK_WS::Logger::infof("收到消息: {}", message);
             
             // 回显消息给发送者
             server.send_message(hdl, "Echo: " + message);
@@ -63,16 +107,20 @@ int main(int argc, char* argv[]) {
         // 设置连接处理器
         server.set_open_handler([&server](auto hdl) {
             server.send_message(hdl, "欢迎连接到WebSocket Echo Server!");
-            KK_WS::Logger::info("当前连接数: " + std::to_string(server.get_connection_count()));
+            KK_WS::Logger::infof("当前连接数: {}", server.get_connection_count());
         });
 
         server.set_close_handler([&server](auto hdl) {
-            KK_WS::Logger::info("当前连接数: " + std::to_string(server.get_connection_count()));
+            KK_WS::Logger::infof("当前连接数: {}", server.get_connection_count());
         });
 
         KK_WS::Logger::info("");
         KK_WS::Logger::info("使用说明:");
-        KK_WS::Logger::info("  - 服务器将回显收到的所有消息");
+        if (config.forward_mode == KK_WS::server::ForwardMode::Relay) {
+            KK_WS::Logger::info("  - 服务器将收到的消息原样转发给其他所有客户端");
+        } else {
+            KK_WS::Logger::info("  - 服务器将回显收到的所有消息");
+        }
         KK_WS::Logger::info("  - 按 Ctrl+C 停止服务器");
         KK_WS::Logger::info("");
         KK_WS::Logger::info("测试命令 (使用 websocat 或其他客户端):");
@@ -85,6 +133,11 @@ int main(int argc, char* argv[]) {
         g_server = nullptr;
         KK_WS::Logger::info("服务器已正常退出");
 
+        if (KK_WS::Logger::dropped_count() > 0) {
+            KK_WS::Logger::warning("日志缓冲区已满，共丢弃 " +
+                                   std::to_string(KK_WS::Logger::dropped_count()) + " 条日志");
+        }
+
     } catch (const std::exception& e) {
         KK_WS::Logger::error("服务器错误: " + std::string(e.what()));
         return 1;
@@ -0,0 +1,172 @@
+#include "outbound_queue.hpp"
+#include "ws_common/logger.hpp"
+#include <vector>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 写完成令牌
+ *
+ * 交给websocketpp的是指向共享帧、但与令牌共用引用计数的别名指针。
+ * websocketpp写完后释放它，令牌随之析构并通知队列。
+ */
+struct OutboundQueue::WriteToken {
+    WriteToken(message_ptr f, std::weak_ptr<OutboundQueue> q, size_t b)
+        : frame(std::move(f)), queue(std::move(q)), bytes(b) {}
+
+    ~WriteToken() {
+        if (auto q = queue.lock()) {
+            q->on_written(bytes);
+        }
+    }
+
+    message_ptr frame;
+    std::weak_ptr<OutboundQueue> queue;
+    size_t bytes;
+};
+
+OutboundQueue::OutboundQueue(server_t::connection_ptr con,
+                             boost::asio::io_service& io_service,
+                             const ServerConfig& config)
+    : con_(std::move(con))
+    , io_service_(io_service)
+    , max_bytes_(config.send_queue_max_bytes)
+    , max_messages_(config.send_queue_max_messages)
+    , policy_(config.send_queue_overflow) {
+}
+
+size_t OutboundQueue::frame_size(const message_ptr& frame) {
+    return frame->get_header().size() + frame->get_payload().size();
+}
+
+OutboundQueue::PushResult OutboundQueue::push(message_ptr frame) {
+    const size_t size = frame_size(frame);
+
+    // 在释放mutex_之后才析构，避免令牌在持锁时回调on_written
+    std::vector<message_ptr> handed;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (closed_) {
+        dropped_messages_++;
+        dropped_bytes_ += size;
+        return PushResult::Dropped;
+    }
+
+    if (over_limit_locked(size)) {
+        switch (policy_) {
+        case OverflowPolicy::DropNewest:
+            dropped_messages_++;
+            dropped_bytes_ += size;
+            return PushResult::Dropped;
+
+        case OverflowPolicy::DropOldest:
+            // 只能丢弃尚未交给websocketpp的帧
+            while (!pending_.empty() && over_limit_locked(size)) {
+                pending_bytes_ -= frame_size(pending_.front());
+                dropped_bytes_ += frame_size(pending_.front());
+                dropped_messages_++;
+                pending_.pop_front();
+            }
+            if (over_limit_locked(size)) {
+                dropped_messages_++;
+                dropped_bytes_ += size;
+                return PushResult::Dropped;
+            }
+            break;
+
+        case OverflowPolicy::Disconnect: {
+            closed_ = true;
+            dropped_messages_ += pending_.size() + 1;
+            dropped_bytes_ += pending_bytes_ + size;
+            pending_.clear();
+            pending_bytes_ = 0;
+            lock.unlock();
+
+            Logger::warning("发送队列溢出，断开慢速客户端: " + con_->get_remote_endpoint());
+            websocketpp::lib::error_code ec;
+            con_->close(websocketpp::close::status::policy_violation, "发送队列溢出", ec);
+            return PushResult::Disconnected;
+        }
+        }
+    }
+
+    pending_.push_back(std::move(frame));
+    pending_bytes_ += size;
+    drain_locked(handed);
+    return PushResult::Queued;
+}
+
+SendQueueStats OutboundQueue::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SendQueueStats stats;
+    stats.queued_messages = pending_.size() + inflight_messages_;
+    stats.queued_bytes = pending_bytes_ + inflight_bytes_;
+    stats.inflight_messages = inflight_messages_;
+    stats.dropped_messages = dropped_messages_;
+    stats.dropped_bytes = dropped_bytes_;
+    return stats;
+}
+
+bool OutboundQueue::over_limit_locked(size_t extra_bytes) const {
+    const size_t messages = pending_.size() + inflight_messages_;
+    if (messages == 0) {
+        return false;
+    }
+    return messages + 1 > max_messages_ ||
+           pending_bytes_ + inflight_bytes_ + extra_bytes > max_bytes_;
+}
+
+void OutboundQueue::drain_locked(std::vector<message_ptr>& handed) {
+    while (!closed_ && !pending_.empty() &&
+           inflight_messages_ < kInflightMessages && inflight_bytes_ < kInflightBytes) {
+        message_ptr frame = std::move(pending_.front());
+        pending_.pop_front();
+
+        const size_t size = frame_size(frame);
+        pending_bytes_ -= size;
+        inflight_messages_++;
+        inflight_bytes_ += size;
+
+        auto token = std::make_shared<WriteToken>(std::move(frame), weak_from_this(), size);
+        message_ptr tracked(token, token->frame.get());
+        handed.push_back(tracked);
+
+        websocketpp::lib::error_code ec = con_->send(tracked);
+        if (ec) {
+            // 连接已不可写，剩余排队帧全部丢弃
+            closed_ = true;
+            dropped_messages_ += pending_.size();
+            dropped_bytes_ += pending_bytes_;
+            pending_.clear();
+            pending_bytes_ = 0;
+        }
+    }
+}
+
+void OutboundQueue::on_written(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    inflight_messages_--;
+    inflight_bytes_ -= bytes;
+
+    if (!pending_.empty() && !closed_) {
+        schedule_drain_locked();
+    }
+}
+
+void OutboundQueue::schedule_drain_locked() {
+    if (drain_scheduled_) {
+        return;
+    }
+    drain_scheduled_ = true;
+
+    // 令牌在websocketpp的写完成路径中析构，不能在那里直接调用send
+    boost::asio::post(io_service_, [self = shared_from_this()]() {
+        std::vector<message_ptr> handed;
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        self->drain_scheduled_ = false;
+        self->drain_locked(handed);
+    });
+}
+
+} // namespace KK_WS::server
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ws_server/server.hpp"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 每个连接的有界发送队列
+ *
+ * 只有一个小窗口的帧交给websocketpp（在途），其余留在本队列中等待，
+ * 这样drop-oldest策略才有可丢弃的对象。交给websocketpp的帧通过别名
+ * shared_ptr携带一个写完成令牌：websocketpp写出后释放该帧，令牌析构时
+ * 扣减在途计数并调度下一批发送。
+ *
+ * 上限同时约束字节数和消息数（在途 + 排队），空队列时允许单条超限消息。
+ */
+class OutboundQueue : public std::enable_shared_from_this<OutboundQueue> {
+public:
+    enum class PushResult {
+        Queued,       // 已入队
+        Dropped,      // 按策略丢弃了新消息
+        Disconnected  // 溢出且策略为断开连接
+    };
+
+    OutboundQueue(server_t::connection_ptr con,
+                  boost::asio::io_service& io_service,
+                  const ServerConfig& config);
+
+    /**
+     * @brief 发送一个已编码的帧（必须是prepared message）
+     */
+    PushResult push(message_ptr frame);
+
+    SendQueueStats stats() const;
+
+private:
+    struct WriteToken;
+
+    bool over_limit_locked(size_t extra_bytes) const;
+    // 在持锁状态下把排队的帧交给websocketpp，直到在途窗口占满
+    void drain_locked(std::vector<message_ptr>& handed);
+    void on_written(size_t bytes);
+    void schedule_drain_locked();
+
+    static size_t frame_size(const message_ptr& frame);
+
+private:
+    // 交给websocketpp的在途窗口
+    static constexpr size_t kInflightMessages = 64;
+    static constexpr size_t kInflightBytes = 256 * 1024;
+
+    server_t::connection_ptr con_;
+    boost::asio::io_service& io_service_;
+    const size_t max_bytes_;
+    const size_t max_messages_;
+    const OverflowPolicy policy_;
+
+    mutable std::mutex mutex_;
+    std::deque<message_ptr> pending_;
+    size_t pending_bytes_ = 0;
+    size_t inflight_messages_ = 0;
+    size_t inflight_bytes_ = 0;
+    uint64_t dropped_messages_ = 0;
+    uint64_t dropped_bytes_ = 0;
+    bool drain_scheduled_ = false;
+    bool closed_ = false;
+};
+
+} // namespace KK_WS::server
@@ -0,0 +1,140 @@
+#include "rate_limiter.hpp"
+#include <algorithm>
+
+namespace KK_WS::server {
+
+RateLimiter::RateLimiter(std::shared_ptr<ReadThrottle> throttle,
+                         boost::asio::io_service& io_service,
+                         const ServerConfig& config)
+    : throttle_(std::move(throttle))
+    , policy_(config.rate_limit_policy)
+    , last_refill_(clock::now())
+    , resume_timer_(io_service) {
+    const double burst = std::max(config.rate_limit_burst_seconds, 0.001);
+
+    messages_.rate = std::max(config.rate_limit_messages_per_sec, 0.0);
+    messages_.capacity = std::max(messages_.rate * burst, 1.0);
+    messages_.tokens = messages_.capacity;
+
+    bytes_.rate = std::max(config.rate_limit_bytes_per_sec, 0.0);
+    bytes_.capacity = std::max(bytes_.rate * burst, 1.0);
+    bytes_.tokens = bytes_.capacity;
+}
+
+bool RateLimiter::enabled(const ServerConfig& config) {
+    return config.rate_limit_messages_per_sec > 0 || config.rate_limit_bytes_per_sec > 0;
+}
+
+void RateLimiter::refill_locked(clock::time_point now) {
+    const double seconds = std::chrono::duration<double>(now - last_refill_).count();
+    last_refill_ = now;
+
+    for (Bucket* bucket : {&messages_, &bytes_}) {
+        if (bucket->rate > 0) {
+            bucket->tokens = std::min(bucket->capacity, bucket->tokens + bucket->rate * seconds);
+        }
+    }
+}
+
+RateLimiter::clock::duration RateLimiter::debt_duration_locked() const {
+    double seconds = 0;
+    for (const Bucket* bucket : {&messages_, &bytes_}) {
+        if (bucket->rate > 0 && bucket->tokens < 0) {
+            seconds = std::max(seconds, -bucket->tokens / bucket->rate);
+        }
+    }
+    return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+RateLimiter::Result RateLimiter::admit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refill_locked(clock::now());
+
+    const bool over = (messages_.rate > 0 && messages_.tokens <= 0) ||
+                      (bytes_.rate > 0 && bytes_.tokens <= 0);
+
+    if (policy_ == RateLimitPolicy::Drop) {
+        if (over) {
+            throttle_events_.fetch_add(1, std::memory_order_relaxed);
+            dropped_messages_.fetch_add(1, std::memory_order_relaxed);
+            dropped_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            return Result::Dropped;
+        }
+        messages_.tokens -= 1;
+        bytes_.tokens -= static_cast<double>(bytes);
+        return Result::Admitted;
+    }
+
+    messages_.tokens -= 1;
+    bytes_.tokens -= static_cast<double>(bytes);
+
+    const clock::duration debt = debt_duration_locked();
+    if (debt <= clock::duration::zero()) {
+        return Result::Admitted;
+    }
+
+    // 已经暂停时，websocketpp读缓冲区里剩余的帧仍会送达，只累计欠额，由定时器统一处理
+    if (paused_.load(std::memory_order_relaxed) || closed_) {
+        return Result::Admitted;
+    }
+
+    throttle_events_.fetch_add(1, std::memory_order_relaxed);
+    paused_.store(true, std::memory_order_relaxed);
+    paused_at_ = clock::now();
+
+    throttle_->pause(ReadThrottle::RateLimit);
+    schedule_resume_locked(debt);
+    return Result::Throttled;
+}
+
+void RateLimiter::schedule_resume_locked(clock::duration delay) {
+    resume_timer_.expires_after(delay);
+    resume_timer_.async_wait([weak = weak_from_this()](const boost::system::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        if (auto self = weak.lock()) {
+            self->on_resume_timer();
+        }
+    });
+}
+
+void RateLimiter::on_resume_timer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_ || !paused_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // 暂停期间送达的帧可能又产生了欠额，继续等待
+    refill_locked(clock::now());
+    const clock::duration debt = debt_duration_locked();
+    if (debt > clock::duration::zero()) {
+        schedule_resume_locked(debt);
+        return;
+    }
+
+    paused_ns_.fetch_add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - paused_at_).count()),
+        std::memory_order_relaxed);
+    paused_.store(false, std::memory_order_relaxed);
+
+    throttle_->resume(ReadThrottle::RateLimit);
+}
+
+void RateLimiter::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    resume_timer_.cancel();
+}
+
+RateLimitStats RateLimiter::stats() const {
+    RateLimitStats stats;
+    stats.throttled = paused_.load(std::memory_order_relaxed);
+    stats.throttle_events = throttle_events_.load(std::memory_order_relaxed);
+    stats.dropped_messages = dropped_messages_.load(std::memory_order_relaxed);
+    stats.dropped_bytes = dropped_bytes_.load(std::memory_order_relaxed);
+    stats.paused_ns = paused_ns_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace KK_WS::server
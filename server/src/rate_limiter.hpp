@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ws_server/server.hpp"
+#include "read_throttle.hpp"
+#include <boost/asio/steady_timer.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 每个连接的接收限速（消息数与字节数两个令牌桶）
+ *
+ * 令牌按配置的速率持续补充，桶容量为burst_seconds秒的额度。消息到达时
+ * 从两个桶中扣除相应令牌，余额允许暂时为负（欠额），因此单条大于桶容量的
+ * 消息也能通过，只是之后需要更长时间还清欠额。
+ *
+ * - PauseReading：出现欠额时通过ReadThrottle暂停读取该连接，定时器在欠额还清后恢复读取；
+ *   暂停期间内核接收缓冲区填满，TCP窗口关闭，对端的发送被反压
+ * - Drop：到达时任一桶余额不为正则丢弃该消息，不扣除令牌
+ *
+ * admit()在连接的strand上调用，恢复读取的定时器在io_service的任意线程上
+ * 执行，两者通过mutex_互斥；统计字段为原子变量，可从任意线程读取。
+ */
+class RateLimiter : public std::enable_shared_from_this<RateLimiter> {
+public:
+    enum class Result {
+        Admitted,   // 未超限，或已处于暂停状态
+        Throttled,  // 超限，开始暂停读取；本条消息照常处理
+        Dropped     // 超限，本条消息被丢弃
+    };
+
+    RateLimiter(std::shared_ptr<ReadThrottle> throttle,
+                boost::asio::io_service& io_service,
+                const ServerConfig& config);
+
+    /**
+     * @brief 配置中是否启用了任何限速
+     */
+    static bool enabled(const ServerConfig& config);
+
+    /**
+     * @brief 记录一条收到的消息
+     */
+    Result admit(size_t bytes);
+
+    /**
+     * @brief 连接关闭时取消恢复读取的定时器
+     */
+    void close();
+
+    RateLimitStats stats() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Bucket {
+        double rate = 0;      // 每秒补充的令牌数，0表示不限制
+        double capacity = 0;
+        double tokens = 0;
+    };
+
+    void refill_locked(clock::time_point now);
+    // 还清两个桶中欠额所需的时间
+    clock::duration debt_duration_locked() const;
+    void schedule_resume_locked(clock::duration delay);
+    void on_resume_timer();
+
+private:
+    std::shared_ptr<ReadThrottle> throttle_;
+    const RateLimitPolicy policy_;
+
+    mutable std::mutex mutex_;
+    Bucket messages_;
+    Bucket bytes_;
+    clock::time_point last_refill_;
+    boost::asio::steady_timer resume_timer_;
+    clock::time_point paused_at_;
+    bool closed_ = false;
+
+    std::atomic<bool> paused_{false};
+    std::atomic<uint64_t> throttle_events_{0};
+    std::atomic<uint64_t> dropped_messages_{0};
+    std::atomic<uint64_t> dropped_bytes_{0};
+    std::atomic<uint64_t> paused_ns_{0};
+};
+
+} // namespace KK_WS::server
@@ -0,0 +1,37 @@
+#include "read_throttle.hpp"
+#include "ws_common/logger.hpp"
+
+namespace KK_WS::server {
+
+ReadThrottle::ReadThrottle(server_t::connection_ptr con)
+    : con_(std::move(con)) {
+}
+
+void ReadThrottle::pause(Reason reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const unsigned before = reasons_.fetch_or(reason, std::memory_order_acq_rel);
+    if (before != 0) {
+        return;
+    }
+
+    websocketpp::lib::error_code ec = con_->pause_reading();
+    if (ec) {
+        Logger::debugf("暂停读取失败: {}", ec.message());
+    }
+}
+
+void ReadThrottle::resume(Reason reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const unsigned before = reasons_.fetch_and(~static_cast<unsigned>(reason), std::memory_order_acq_rel);
+    if (before != static_cast<unsigned>(reason)) {
+        // 该原因未生效，或还有其他原因要求保持暂停
+        return;
+    }
+
+    websocketpp::lib::error_code ec = con_->resume_reading();
+    if (ec) {
+        Logger::debugf("恢复读取失败: {}", ec.message());
+    }
+}
+
+} // namespace KK_WS::server
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ws_server/server.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 连接读取的暂停与恢复（多个原因共用）
+ *
+ * 暂停读取后内核接收缓冲区填满，TCP窗口关闭，对端的发送被反压。消息处理回调
+ * 积压和接收限速都可能要求暂停读取同一个连接，所有原因都解除后才恢复读取。
+ * pause_reading/resume_reading由websocketpp派发到连接的strand上执行，
+ * pause()/resume()可以在任意线程调用。
+ */
+class ReadThrottle {
+public:
+    enum Reason : unsigned {
+        HandlerBacklog = 1u << 0,  // 等待工作线程处理的消息过多
+        RateLimit = 1u << 1        // 超过接收限速
+    };
+
+    explicit ReadThrottle(server_t::connection_ptr con);
+
+    void pause(Reason reason);
+    void resume(Reason reason);
+
+    bool paused(Reason reason) const {
+        return (reasons_.load(std::memory_order_acquire) & reason) != 0;
+    }
+
+private:
+    server_t::connection_ptr con_;
+    std::mutex mutex_;                  // 串行化原因集合的变化与对应的websocketpp调用
+    std::atomic<unsigned> reasons_{0};
+};
+
+} // namespace KK_WS::server
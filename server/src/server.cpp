@@ -1,90 +1,323 @@
 #include "ws_server/server.hpp"
 #include "ws_common/logger.hpp"
+#include "ws_common/latency_envelope.hpp"
+#include "topic_router.hpp"
+#include "frame_encoder.hpp"
+#include "connection_registry.hpp"
 #include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace KK_WS::server {
 
+// 多线程运行io_service时，依赖websocketpp为每个连接创建strand来串行化回调
+static_assert(server_config::enable_multithreading,
+              "WebSocketServer requires a multithreading-enabled websocketpp config");
+
+namespace {
+
+using connection_ptr = server_t::connection_ptr;
+
+// connection_hdl与endpoint无关，任何分片的连接都可以直接解析
+connection_ptr lock_connection(connection_hdl hdl) {
+    return std::static_pointer_cast<server_t::connection_type>(hdl.lock());
+}
+
+// 分片模式下每个endpoint在bind之前打开SO_REUSEPORT，由内核分配accept
+websocketpp::lib::error_code enable_reuse_port(
+    std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor) {
+#ifdef SO_REUSEPORT
+    using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    boost::system::error_code bec;
+    acceptor->set_option(reuse_port(true), bec);
+    if (bec) {
+        Logger::error("设置SO_REUSEPORT失败: " + bec.message());
+        return websocketpp::transport::asio::error::make_error_code(
+            websocketpp::transport::asio::error::pass_through);
+    }
+    return websocketpp::lib::error_code();
+#else
+    (void)acceptor;
+    Logger::error("当前平台不支持SO_REUSEPORT");
+    return websocketpp::transport::asio::error::make_error_code(
+        websocketpp::transport::asio::error::general);
+#endif
+}
+
+void pin_thread_to_core(std::thread& thread, size_t index) {
+#ifdef __linux__
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % cores, &cpus);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) != 0) {
+        Logger::warning("绑定分片线程到CPU " + std::to_string(index % cores) + " 失败");
+    }
+#else
+    (void)thread;
+    (void)index;
+#endif
+}
+
+// 客户端订阅协议前缀（与 ClientImpl::subscribe/unsubscribe 对应）
+constexpr char kSubscribePrefix[] = "SUBSCRIBE:";
+constexpr char kUnsubscribePrefix[] = "UNSUBSCRIBE:";
+constexpr char kTopicSeparator = '\n';
+
+bool starts_with(std::string_view s, const char* prefix, size_t prefix_len) {
+    return s.size() >= prefix_len && s.compare(0, prefix_len, prefix) == 0;
+}
+
+// 启用了延迟信封的客户端发来的控制消息同样带有信封，识别前先跳过
+std::string_view strip_latency_envelope(std::string_view payload) {
+    if (latency_envelope::parse(payload)) {
+        payload.remove_prefix(latency_envelope::kSize);
+    }
+    return payload;
+}
+
+// 正在执行的消息处理回调所处理消息的延迟信封；回调第一次回复发送方时重新附加，
+// 客户端据此统计往返延迟。回调在单个线程上同步执行，用thread_local传递
+struct PendingReplyEnvelope {
+    connection_id id = invalid_connection_id;
+    std::optional<latency_envelope::Stamp> stamp;
+};
+thread_local PendingReplyEnvelope t_reply_envelope;
+
+} // namespace
+
+struct WebSocketServer::Shard {
+    explicit Shard(size_t i) : index(i), registry(i) {}
+
+    size_t index;
+    server_t endpoint;
+    ConnectionRegistry registry;
+
+    // 每个分片持有独立的回调副本，热路径上不与其他分片共享引用计数
+    std::shared_ptr<const MessageHandler> message_handler;
+    std::shared_ptr<const ConnectionHandler> open_handler;
+    std::shared_ptr<const ConnectionHandler> close_handler;
+};
+
+struct WebSocketServer::Metrics {
+    MetricsRegistry registry;
+
+    Counter& accepts = registry.counter(
+        "ws_server_accepts_total", "已建立的WebSocket连接数（每秒接入数用rate()计算）");
+    Counter& rejected = registry.counter(
+        "ws_server_rejected_connections_total", "因连接槽位耗尽而拒绝的连接数");
+    Counter& messages_received = registry.counter(
+        "ws_server_messages_received_total", "收到的消息数");
+    Counter& bytes_received = registry.counter(
+        "ws_server_received_bytes_total", "收到的消息负载字节数");
+    Counter& messages_sent = registry.counter(
+        "ws_server_messages_sent_total", "放入发送队列的消息数");
+    Counter& bytes_sent = registry.counter(
+        "ws_server_sent_bytes_total", "放入发送队列的帧字节数（含帧头）");
+    Histogram& handler_latency = registry.histogram(
+        "ws_server_handler_duration_seconds", "每条消息在消息处理回调中花费的时间", 1e-9);
+    Counter& rate_limited = registry.counter(
+        "ws_server_rate_limited_total", "连接超过接收限速的次数（暂停读取或丢弃）");
+    Counter& rate_limit_dropped = registry.counter(
+        "ws_server_rate_limit_dropped_messages_total", "因超过接收限速而丢弃的消息数");
+    Gauge& handler_queue = registry.gauge(
+        "ws_server_handler_queue_messages", "已交给工作线程、尚未处理的消息数");
+    Counter& handler_backlog_pauses = registry.counter(
+        "ws_server_handler_backlog_pauses_total", "因处理回调积压达到上限而暂停读取连接的次数");
+};
+
 WebSocketServer::WebSocketServer(const ServerConfig& config)
-    : config_(config) {
-    
+    : config_(config)
+    , metrics_(std::make_unique<Metrics>())
+    , topic_router_(std::make_unique<TopicRouter>())
+    , frame_encoder_(std::make_unique<FrameEncoder>()) {
+
+    if (config_.compression.enabled && config_.send_queue_overflow != OverflowPolicy::Disconnect) {
+        config_.compression.server_no_context_takeover = true;
+    }
+
+    if (config_.io_model == IoModel::ShardedReusePort && config_.io_threads > ConnectionRegistry::kMaxShards) {
+        Logger::warningf("分片数 {} 超过上限 {}，按上限创建", config_.io_threads, ConnectionRegistry::kMaxShards);
+        config_.io_threads = ConnectionRegistry::kMaxShards;
+    }
+
+    const size_t shard_count = config_.io_model == IoModel::ShardedReusePort
+        ? std::max<size_t>(1, config_.io_threads)
+        : 1;
+
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(i));
+        init_shard(*shards_.back());
+    }
+
+    if (config_.handler_threads > 0) {
+        handler_pool_ = std::make_unique<core::IoPool>(config_.handler_threads);
+    }
+
+    // 以下指标在导出时遍历各分片的连接快照求值
+    metrics_->registry.gauge_function("ws_server_connections", "当前连接数", [this]() {
+        return static_cast<double>(get_connection_count());
+    });
+    metrics_->registry.gauge_function("ws_server_throttled_connections", "因超过接收限速而暂停读取的连接数", [this]() {
+        return static_cast<double>(get_throttled_connections().size());
+    });
+    metrics_->registry.gauge_function("ws_server_send_queue_messages", "所有连接发送队列中尚未写出的消息数", [this]() {
+        return static_cast<double>(sum_send_queue_stats().queued_messages);
+    });
+    metrics_->registry.gauge_function("ws_server_send_queue_bytes", "所有连接发送队列中尚未写出的字节数", [this]() {
+        return static_cast<double>(sum_send_queue_stats().queued_bytes);
+    });
+}
+
+WebSocketServer::~WebSocketServer() {
+    stop();
+}
+
+void WebSocketServer::init_shard(Shard& shard) {
+    server_t& endpoint = shard.endpoint;
+
     // 配置日志
     if (!config_.enable_logging) {
-        endpoint_.clear_access_channels(websocketpp::log::alevel::all);
-        endpoint_.clear_error_channels(websocketpp::log::elevel::all);
+        endpoint.clear_access_channels(websocketpp::log::alevel::all);
+        endpoint.clear_error_channels(websocketpp::log::elevel::all);
     } else {
-        endpoint_.set_error_channels(websocketpp::log::elevel::all);
-        endpoint_.set_access_channels(websocketpp::log::alevel::all ^ 
+        endpoint.set_error_channels(websocketpp::log::elevel::all);
+        endpoint.set_access_channels(websocketpp::log::alevel::all ^
                                      websocketpp::log::alevel::frame_payload);
     }
 
-    // 初始化ASIO
-    endpoint_.init_asio();
+    // 初始化ASIO（每个分片拥有独立的io_service）
+    endpoint.init_asio();
 
     // 设置事件处理器
-    endpoint_.set_open_handler([this](connection_hdl hdl) {
-        on_open(hdl);
+    endpoint.set_open_handler([this, &shard](connection_hdl hdl) {
+        on_open(shard, hdl);
     });
 
-    endpoint_.set_close_handler([this](connection_hdl hdl) {
-        on_close(hdl);
+    endpoint.set_close_handler([this, &shard](connection_hdl hdl) {
+        on_close(shard, hdl);
     });
 
-    endpoint_.set_message_handler([this](connection_hdl hdl, message_ptr msg) {
-        on_message(hdl, msg);
+    endpoint.set_message_handler([this, &shard](connection_hdl hdl, message_ptr msg) {
+        on_message(shard, hdl, msg);
     });
 
+    if (!config_.metrics_path.empty()) {
+        endpoint.set_http_handler([this](connection_hdl hdl) {
+            on_http(hdl);
+        });
+    }
+
     // 设置复用地址
-    endpoint_.set_reuse_addr(true);
-}
+    endpoint.set_reuse_addr(true);
 
-WebSocketServer::~WebSocketServer() {
-    stop();
+    if (config_.io_model == IoModel::ShardedReusePort) {
+        endpoint.set_tcp_pre_bind_handler(&enable_reuse_port);
+    }
 }
 
 void WebSocketServer::start() {
+    const bool sharded = config_.io_model == IoModel::ShardedReusePort;
+    const size_t thread_count = std::max<size_t>(1, config_.io_threads);
+
     try {
         Logger::info("启动WebSocket服务器...");
         Logger::info("监听端口: " + std::to_string(config_.port));
         Logger::info("绑定地址: " + config_.bind_address);
+        Logger::info(std::string("IO模型: ") + (sharded ? "SO_REUSEPORT分片" : "共享io_service") +
+                     " (线程数: " + std::to_string(thread_count) + ")");
+        if (handler_pool_) {
+            Logger::infof("消息处理工作线程: {}", handler_pool_->size());
+        }
 
-        // 监听指定端口
-        endpoint_.listen(config_.port);
+        running_ = true;
 
-        // 开始接受连接
-        endpoint_.start_accept();
+        // 监听指定端口，分片模式下每个分片各自监听同一端口
+        for (auto& shard : shards_) {
+            shard->endpoint.listen(config_.port);
+            shard->endpoint.start_accept();
+        }
 
         Logger::info("服务器启动成功，等待连接...");
+        if (!config_.metrics_path.empty()) {
+            Logger::infof("Prometheus指标: http://{}:{}{}", config_.bind_address, config_.port, config_.metrics_path);
+        }
 
-        // 运行事件循环（阻塞）
-        endpoint_.run();
+        if (sharded) {
+            for (auto& shard : shards_) {
+                server_t& endpoint = shard->endpoint;
+                io_threads_.emplace_back([this, &endpoint]() {
+                    server_config::permessage_deflate_type::bind_to_thread(config_.compression);
+                    try {
+                        endpoint.run();
+                    } catch (const std::exception& e) {
+                        Logger::error("分片IO线程异常: " + std::string(e.what()));
+                    }
+                });
+                if (config_.pin_io_threads) {
+                    pin_thread_to_core(io_threads_.back(), shard->index);
+                }
+            }
+        } else {
+            server_t& endpoint = shards_.front()->endpoint;
+            for (size_t i = 0; i < thread_count; ++i) {
+                io_threads_.emplace_back([this, &endpoint]() {
+                    // 本服务器的连接在这些线程上创建协议处理器，压缩参数随之复制到每个连接
+                    server_config::permessage_deflate_type::bind_to_thread(config_.compression);
+                    try {
+                        endpoint.run();
+                    } catch (const std::exception& e) {
+                        Logger::error("IO线程异常: " + std::string(e.what()));
+                    }
+                });
+            }
+        }
 
     } catch (const websocketpp::exception& e) {
         Logger::error("WebSocket异常: " + std::string(e.what()));
+        stop();
     } catch (const std::exception& e) {
         Logger::error("启动服务器失败: " + std::string(e.what()));
+        stop();
+    }
+
+    // 阻塞直到所有IO线程退出
+    for (auto& t : io_threads_) {
+        if (t.joinable()) {
+            t.join();
+        }
     }
+    io_threads_.clear();
 }
 
 void WebSocketServer::stop() {
+    // 信号处理、析构函数都可能调用stop()，只执行一次
+    if (!running_.exchange(false)) {
+        return;
+    }
+
     try {
         Logger::info("停止WebSocket服务器...");
-        
-        // 关闭所有连接
-        {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            for (auto hdl : connections_) {
+
+        for (auto& shard : shards_) {
+            // 关闭所有连接
+            auto sessions = shard->registry.snapshot();
+            for (const auto& session : *sessions) {
                 websocketpp::lib::error_code ec;
-                endpoint_.close(hdl, websocketpp::close::status::going_away, 
-                              "服务器关闭", ec);
+                session->con->close(websocketpp::close::status::going_away, "服务器关闭", ec);
             }
-            connections_.clear();
-        }
 
-        // 停止监听
-        endpoint_.stop_listening();
-        
-        // 停止服务器
-        endpoint_.stop();
+            // 停止监听
+            websocketpp::lib::error_code ec;
+            shard->endpoint.stop_listening(ec);
+
+            // 停止服务器
+            shard->endpoint.stop();
+        }
 
         Logger::info("服务器已停止");
 
@@ -94,86 +327,455 @@ void WebSocketServer::stop() {
 }
 
 void WebSocketServer::send_message(connection_hdl hdl, const std::string& message) {
-    try {
-        websocketpp::lib::error_code ec;
-        endpoint_.send(hdl, message, websocketpp::frame::opcode::text, ec);
-        
-        if (ec) {
-            Logger::error("发送消息失败: " + ec.message());
+    if (!send_message(get_connection_id(hdl), message)) {
+        Logger::error("发送消息失败: 连接已失效或发送队列已满");
+    }
+}
+
+bool WebSocketServer::send_message(connection_id id, const std::string& message) {
+    if (t_reply_envelope.stamp && t_reply_envelope.id == id) {
+        std::string enveloped = latency_envelope::encode(*t_reply_envelope.stamp);
+        t_reply_envelope.stamp.reset();
+        enveloped += message;
+        return send_message(id, enveloped);
+    }
+
+    auto session = find_session(id);
+    if (!session) {
+        return false;
+    }
+
+    if (session->deflate_encoder && message.size() >= config_.compression.min_size) {
+        return send_payload(*session, message, nullptr);
+    }
+
+    message_ptr frame = frame_encoder_->encode(message);
+    return frame && send_frame(*session, frame);
+}
+
+void WebSocketServer::send_batch(connection_hdl hdl, std::vector<ws_message>&& messages) {
+    if (!send_batch(get_connection_id(hdl), std::move(messages))) {
+        Logger::error("批量发送消息失败: 连接已失效或发送队列已满");
+    }
+}
+
+bool WebSocketServer::send_batch(connection_id id, std::vector<ws_message>&& messages) {
+    auto session = find_session(id);
+    if (!session) {
+        return false;
+    }
+    if (messages.empty()) {
+        return true;
+    }
+
+    if (!session->deflate_encoder) {
+        message_ptr frame = frame_encoder_->encode_batch(messages);
+        return frame && send_frame(*session, frame, messages.size());
+    }
+
+    // 批内可能有压缩帧，编码和入队都在deflate_mutex下完成
+    std::lock_guard<std::mutex> lock(session->deflate_mutex);
+    message_ptr frame = frame_encoder_->encode_batch(
+        messages, session->deflate_encoder.get(), config_.compression.min_size);
+    return frame && send_frame(*session, frame, messages.size());
+}
+
+connection_id WebSocketServer::get_connection_id(connection_hdl hdl) const {
+    auto con = lock_connection(hdl);
+    return con ? con->server_connection_id.load(std::memory_order_relaxed)
+               : invalid_connection_id;
+}
+
+std::shared_ptr<Session> WebSocketServer::find_session(connection_id id) const {
+    const size_t shard = ConnectionRegistry::shard_of(id);
+    return shard < shards_.size() ? shards_[shard]->registry.find(id) : nullptr;
+}
+
+std::optional<SendQueueStats> WebSocketServer::get_send_queue_stats(connection_id id) const {
+    auto session = find_session(id);
+    if (!session) {
+        return std::nullopt;
+    }
+    return session->outbound->stats();
+}
+
+std::optional<RateLimitStats> WebSocketServer::get_rate_limit_stats(connection_id id) const {
+    auto session = find_session(id);
+    if (!session) {
+        return std::nullopt;
+    }
+    return session->rate_limiter ? session->rate_limiter->stats() : RateLimitStats{};
+}
+
+std::vector<connection_id> WebSocketServer::get_throttled_connections() const {
+    std::vector<connection_id> result;
+    if (!RateLimiter::enabled(config_)) {
+        return result;
+    }
+    for (const auto& shard : shards_) {
+        auto sessions = shard->registry.snapshot();
+        for (const auto& session : *sessions) {
+            if (session->rate_limiter && session->rate_limiter->stats().throttled) {
+                result.push_back(session->id);
+            }
         }
-    } catch (const std::exception& e) {
-        Logger::error("发送消息异常: " + std::string(e.what()));
     }
+    return result;
+}
+
+bool WebSocketServer::send_frame(Session& session, const message_ptr& frame, size_t message_count) {
+    // 所有发送都经过连接的有界队列，溢出时按配置的策略处理
+    if (session.outbound->push(frame) != OutboundQueue::PushResult::Queued) {
+        return false;
+    }
+    metrics_->messages_sent.add(message_count);
+    metrics_->bytes_sent.add(frame->get_header().size() + frame->get_payload().size());
+    return true;
+}
+
+bool WebSocketServer::send_payload(Session& session, const std::string& payload, const message_ptr& frame,
+                                   websocketpp::frame::opcode::value opcode) {
+    if (!session.deflate_encoder || payload.size() < config_.compression.min_size) {
+        return frame && send_frame(session, frame);
+    }
+
+    std::lock_guard<std::mutex> lock(session.deflate_mutex);
+    message_ptr compressed = session.deflate_encoder->encode(payload, opcode, true);
+    return compressed && send_frame(session, compressed);
+}
+
+bool WebSocketServer::echo_message(connection_hdl hdl, const message_ptr& msg) {
+    auto session = find_session(get_connection_id(hdl));
+    if (!session || !FrameEncoder::prepare_in_place(msg)) {
+        return false;
+    }
+    // 队列溢出由发送队列按策略处理并计入丢弃统计，这里不再逐条记录日志
+    return send_payload(*session, msg->get_payload(), msg, msg->get_opcode());
+}
+
+size_t WebSocketServer::relay_message(connection_hdl hdl, const message_ptr& msg) {
+    if (!FrameEncoder::prepare_in_place(msg)) {
+        return 0;
+    }
+
+    const connection_id sender = get_connection_id(hdl);
+    size_t delivered = 0;
+    for (auto& shard : shards_) {
+        auto sessions = shard->registry.snapshot();
+        for (const auto& session : *sessions) {
+            if (session->id != sender &&
+                send_payload(*session, msg->get_payload(), msg, msg->get_opcode())) {
+                ++delivered;
+            }
+        }
+    }
+    return delivered;
 }
 
 void WebSocketServer::broadcast(const std::string& message) {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    
-    Logger::debug("广播消息到 " + std::to_string(connections_.size()) + " 个客户端");
-    
-    for (auto hdl : connections_) {
-        send_message(hdl, message);
+    // 编码一次，所有未压缩的连接共享同一帧
+    message_ptr frame = frame_encoder_->encode(message);
+    if (!frame) {
+        return;
+    }
+
+    for (auto& shard : shards_) {
+        // 快照不可变，遍历期间不持有任何锁
+        auto sessions = shard->registry.snapshot();
+
+        Logger::debugf("广播消息到分片 {} 的 {} 个客户端", shard->index, sessions->size());
+
+        for (const auto& session : *sessions) {
+            send_payload(*session, message, frame);
+        }
     }
 }
 
+size_t WebSocketServer::publish(const std::string& topic, const std::string& payload) {
+    // 在主题分段的锁下取得订阅者快照（订阅变更后的首次发布时重建），发送时不持有任何锁
+    auto subscribers = topic_router_->subscribers(topic);
+    if (!subscribers) {
+        return 0;
+    }
+
+    message_ptr frame = frame_encoder_->encode(payload);
+    if (!frame) {
+        return 0;
+    }
+
+    size_t delivered = 0;
+    for (connection_id id : *subscribers) {
+        auto session = find_session(id);
+        if (session && send_payload(*session, payload, frame)) {
+            ++delivered;
+        }
+    }
+    return delivered;
+}
+
+size_t WebSocketServer::get_subscriber_count(const std::string& topic) const {
+    return topic_router_->subscriber_count(topic);
+}
+
 void WebSocketServer::set_message_handler(MessageHandler handler) {
-    message_handler_ = handler;
+    for (auto& shard : shards_) {
+        std::atomic_store(&shard->message_handler,
+                          std::make_shared<const MessageHandler>(handler));
+    }
 }
 
 void WebSocketServer::set_open_handler(ConnectionHandler handler) {
-    open_handler_ = handler;
+    for (auto& shard : shards_) {
+        std::atomic_store(&shard->open_handler,
+                          std::make_shared<const ConnectionHandler>(handler));
+    }
 }
 
 void WebSocketServer::set_close_handler(ConnectionHandler handler) {
-    close_handler_ = handler;
+    for (auto& shard : shards_) {
+        std::atomic_store(&shard->close_handler,
+                          std::make_shared<const ConnectionHandler>(handler));
+    }
+}
+
+SendQueueStats WebSocketServer::sum_send_queue_stats() const {
+    SendQueueStats total;
+    for (auto& shard : shards_) {
+        auto sessions = shard->registry.snapshot();
+        for (const auto& session : *sessions) {
+            const SendQueueStats stats = session->outbound->stats();
+            total.queued_messages += stats.queued_messages;
+            total.queued_bytes += stats.queued_bytes;
+            total.inflight_messages += stats.inflight_messages;
+            total.dropped_messages += stats.dropped_messages;
+            total.dropped_bytes += stats.dropped_bytes;
+        }
+    }
+    return total;
+}
+
+MetricsRegistry& WebSocketServer::metrics() {
+    return metrics_->registry;
 }
 
 size_t WebSocketServer::get_connection_count() const {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    return connections_.size();
+    size_t total = 0;
+    for (auto& shard : shards_) {
+        total += shard->registry.size();
+    }
+    return total;
 }
 
-void WebSocketServer::on_open(connection_hdl hdl) {
-    {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
-        connections_.insert(hdl);
+void WebSocketServer::on_open(Shard& shard, connection_hdl hdl) {
+    auto con = shard.endpoint.get_con_from_hdl(hdl);
+
+    auto session = std::make_shared<Session>();
+    session->con = con;
+    session->outbound = std::make_shared<OutboundQueue>(con, shard.endpoint.get_io_service(), config_);
+    if (config_.compression.enabled) {
+        session->deflate_encoder = FrameEncoder::for_compressed_connection(con);
+    }
+    if (RateLimiter::enabled(config_) || handler_pool_) {
+        session->read_throttle = std::make_shared<ReadThrottle>(con);
+    }
+    if (RateLimiter::enabled(config_)) {
+        session->rate_limiter = std::make_shared<RateLimiter>(
+            session->read_throttle, shard.endpoint.get_io_service(), config_);
+    }
+
+    session = shard.registry.add(std::move(session));
+    if (!session) {
+        metrics_->rejected.add();
+        Logger::error("连接槽位已耗尽，拒绝新连接: " + con->get_remote_endpoint());
+        websocketpp::lib::error_code ec;
+        con->close(websocketpp::close::status::try_again_later, "服务器繁忙", ec);
+        return;
     }
+    con->server_connection_id.store(session->id, std::memory_order_relaxed);
+    metrics_->accepts.add();
 
-    auto con = endpoint_.get_con_from_hdl(hdl);
-    Logger::info("新客户端连接: " + con->get_remote_endpoint() + 
-                 " (总数: " + std::to_string(get_connection_count()) + ")");
+    Logger::infof("新客户端连接: {} (总数: {})",
+                  [&con]() { return con->get_remote_endpoint(); },
+                  [this]() { return get_connection_count(); });
 
-    if (open_handler_) {
-        open_handler_(hdl);
+    auto handler = std::atomic_load(&shard.open_handler);
+    if (handler && *handler) {
+        (*handler)(hdl);
     }
 }
 
-void WebSocketServer::on_close(connection_hdl hdl) {
-    {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
-        connections_.erase(hdl);
+void WebSocketServer::on_close(Shard& shard, connection_hdl hdl) {
+    const connection_id id = get_connection_id(hdl);
+    if (id != invalid_connection_id) {
+        auto session = shard.registry.remove(id);
+        if (session && session->rate_limiter) {
+            session->rate_limiter->close();
+        }
+        topic_router_->remove_connection(id);
     }
 
-    Logger::info("客户端断开连接 (剩余: " + 
-                 std::to_string(get_connection_count()) + ")");
+    Logger::infof("客户端断开连接 (剩余: {})", [this]() { return get_connection_count(); });
 
-    if (close_handler_) {
-        close_handler_(hdl);
+    auto handler = std::atomic_load(&shard.close_handler);
+    if (handler && *handler) {
+        (*handler)(hdl);
     }
 }
 
-void WebSocketServer::on_message(connection_hdl hdl, message_ptr msg) {
+void WebSocketServer::on_message(Shard& shard, connection_hdl hdl, message_ptr msg) {
     const std::string& payload = msg->get_payload();
-    
-    Logger::debug("收到消息: " + payload.substr(0, std::min(size_t(50), payload.size())) + 
-                  (payload.size() > 50 ? "..." : ""));
 
-    if (message_handler_) {
-        message_handler_(hdl, payload);
-    } else {
-        // 默认行为：回显消息
-        send_message(hdl, payload);
+    metrics_->messages_received.add();
+    metrics_->bytes_received.add(payload.size());
+
+    Logger::debugf("收到消息: {}", Logger::preview(payload, 50));
+
+    if (RateLimiter::enabled(config_)) {
+        auto session = find_session(get_connection_id(hdl));
+        if (session && session->rate_limiter) {
+            switch (session->rate_limiter->admit(payload.size())) {
+            case RateLimiter::Result::Admitted:
+                break;
+            case RateLimiter::Result::Throttled:
+                // 已暂停读取，本条消息已经读出，照常处理
+                metrics_->rate_limited.add();
+                break;
+            case RateLimiter::Result::Dropped:
+                metrics_->rate_limited.add();
+                metrics_->rate_limit_dropped.add();
+                return;
+            }
+        }
+    }
+
+    if (msg->get_opcode() == websocketpp::frame::opcode::text &&
+        handle_subscription(hdl, strip_latency_envelope(payload))) {
+        return;
+    }
+
+    if (config_.forward_mode == ForwardMode::Echo) {
+        echo_message(hdl, msg);
+        return;
+    }
+    if (config_.forward_mode == ForwardMode::Relay) {
+        relay_message(hdl, msg);
+        return;
+    }
+
+    auto handler = std::atomic_load(&shard.message_handler);
+    if (!handler || !*handler) {
+        // 默认行为：原样回显消息
+        echo_message(hdl, msg);
+        return;
+    }
+
+    if (handler_pool_) {
+        // 同一连接总是投递到同一个单线程事件循环，消息按收到的顺序依次处理；
+        // 任务持有msg，负载在回调结束前一直有效
+        auto session = find_session(get_connection_id(hdl));
+        if (!session) {
+            return;
+        }
+
+        // 积压达到上限时先暂停读取再投递：之后投递的任务完成时一定能看到暂停状态并负责恢复
+        const size_t limit = std::max<size_t>(1, config_.handler_queue_max_messages);
+        if (session->handler_pending.fetch_add(1, std::memory_order_acq_rel) + 1 >= limit &&
+            !session->read_throttle->paused(ReadThrottle::HandlerBacklog)) {
+            metrics_->handler_backlog_pauses.add();
+            session->read_throttle->pause(ReadThrottle::HandlerBacklog);
+        }
+
+        metrics_->handler_queue.add();
+        boost::asio::post(handler_pool_->at(session->id), [this, handler, hdl, msg, session, limit]() {
+            metrics_->handler_queue.sub();
+            run_handler(*handler, hdl, msg);
+
+            const size_t pending = session->handler_pending.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            if (pending <= limit / 2 && session->read_throttle->paused(ReadThrottle::HandlerBacklog)) {
+                session->read_throttle->resume(ReadThrottle::HandlerBacklog);
+            }
+        });
+        return;
+    }
+
+    run_handler(*handler, hdl, msg);
+}
+
+void WebSocketServer::run_handler(const MessageHandler& handler, connection_hdl hdl, const message_ptr& msg) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // 回调只看到原始负载：信封从消息中原地去掉，记下后由回复时的send_message()重新附加
+    std::string& payload = msg->get_raw_payload();
+    t_reply_envelope = {};  // 上一个回调抛出异常时可能残留
+    if (auto stamp = latency_envelope::parse(payload)) {
+        payload.erase(0, latency_envelope::kSize);
+        t_reply_envelope = {get_connection_id(hdl), stamp};
+    }
+
+    handler(hdl, payload);
+    t_reply_envelope = {};
+
+    metrics_->handler_latency.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+}
+
+void WebSocketServer::on_http(connection_hdl hdl) {
+    auto con = lock_connection(hdl);
+    if (!con) {
+        return;
+    }
+
+    std::string resource = con->get_resource();
+    resource = resource.substr(0, resource.find('?'));
+
+    if (resource != config_.metrics_path) {
+        con->set_status(websocketpp::http::status_code::not_found);
+        return;
+    }
+
+    // 在IO线程上直接生成响应，抓取指标不需要额外的线程或端口
+    std::string body;
+    metrics_->registry.render_prometheus(body);
+    MetricsRegistry::global().render_prometheus(body);
+
+    con->set_status(websocketpp::http::status_code::ok);
+    con->append_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    con->set_body(std::move(body));
+}
+
+bool WebSocketServer::handle_subscription(connection_hdl hdl, std::string_view payload) {
+    constexpr size_t sub_len = sizeof(kSubscribePrefix) - 1;
+    constexpr size_t unsub_len = sizeof(kUnsubscribePrefix) - 1;
+
+    const bool subscribe = starts_with(payload, kSubscribePrefix, sub_len);
+    if (!subscribe && !starts_with(payload, kUnsubscribePrefix, unsub_len)) {
+        return false;
+    }
+
+    const connection_id id = get_connection_id(hdl);
+    if (id == invalid_connection_id) {
+        return true;
+    }
+
+    // 一条消息可以携带多个以换行分隔的主题（客户端重连后批量恢复订阅）
+    size_t begin = subscribe ? sub_len : unsub_len;
+    while (begin <= payload.size()) {
+        size_t end = payload.find(kTopicSeparator, begin);
+        if (end == std::string_view::npos) {
+            end = payload.size();
+        }
+
+        std::string topic(payload.substr(begin, end - begin));
+        if (!topic.empty()) {
+            if (subscribe && topic_router_->subscribe(id, topic)) {
+                Logger::debugf("客户端订阅主题: {}", topic);
+            } else if (!subscribe && topic_router_->unsubscribe(id, topic)) {
+                Logger::debugf("客户端取消订阅: {}", topic);
+            }
+        }
+        begin = end + 1;
     }
+    return true;
 }
 
 } // namespace KK_WS::server
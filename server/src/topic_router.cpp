@@ -0,0 +1,130 @@
+#include "topic_router.hpp"
+#include <functional>
+
+namespace KK_WS::server {
+
+TopicRouter::Stripe& TopicRouter::stripe_for(const std::string& topic) {
+    return stripes_[std::hash<std::string>{}(topic) % kStripeCount];
+}
+
+const TopicRouter::Stripe& TopicRouter::stripe_for(const std::string& topic) const {
+    return stripes_[std::hash<std::string>{}(topic) % kStripeCount];
+}
+
+bool TopicRouter::subscribe(connection_id id, const std::string& topic) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    if (!topics_by_connection_[id].insert(topic).second) {
+        return false;
+    }
+    add_subscriber(topic, id);
+    return true;
+}
+
+bool TopicRouter::unsubscribe(connection_id id, const std::string& topic) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto it = topics_by_connection_.find(id);
+    if (it == topics_by_connection_.end() || it->second.erase(topic) == 0) {
+        return false;
+    }
+    if (it->second.empty()) {
+        topics_by_connection_.erase(it);
+    }
+    remove_subscriber(topic, id);
+    return true;
+}
+
+void TopicRouter::remove_connection(connection_id id) {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto it = topics_by_connection_.find(id);
+    if (it == topics_by_connection_.end()) {
+        return;
+    }
+    for (const auto& topic : it->second) {
+        remove_subscriber(topic, id);
+    }
+    topics_by_connection_.erase(it);
+}
+
+TopicRouter::SubscriberSnapshot TopicRouter::subscribers(const std::string& topic) const {
+    const Stripe& stripe = stripe_for(topic);
+    {
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        auto it = stripe.topics.find(topic);
+        if (it == stripe.topics.end()) {
+            return nullptr;
+        }
+        if (it->second.snapshot) {
+            return it->second.snapshot;
+        }
+    }
+
+    // 订阅变更后的第一次发布：在写锁下按当前订阅者重建快照，之后的发布直接复用
+    std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+    auto it = stripe.topics.find(topic);
+    if (it == stripe.topics.end()) {
+        return nullptr;
+    }
+    if (!it->second.snapshot) {
+        it->second.snapshot = std::make_shared<const SubscriberList>(it->second.members);
+    }
+    return it->second.snapshot;
+}
+
+size_t TopicRouter::subscriber_count(const std::string& topic) const {
+    const Stripe& stripe = stripe_for(topic);
+    std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+    auto it = stripe.topics.find(topic);
+    return it != stripe.topics.end() ? it->second.members.size() : 0;
+}
+
+size_t TopicRouter::topic_count() const {
+    size_t total = 0;
+    for (const auto& stripe : stripes_) {
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        total += stripe.topics.size();
+    }
+    return total;
+}
+
+void TopicRouter::add_subscriber(const std::string& topic, connection_id id) {
+    Stripe& stripe = stripe_for(topic);
+    std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+
+    Topic& entry = stripe.topics[topic];
+    entry.position.emplace(id, entry.members.size());
+    entry.members.push_back(id);
+    entry.snapshot.reset();
+}
+
+void TopicRouter::remove_subscriber(const std::string& topic, connection_id id) {
+    Stripe& stripe = stripe_for(topic);
+    std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+
+    auto it = stripe.topics.find(topic);
+    if (it == stripe.topics.end()) {
+        return;
+    }
+
+    Topic& entry = it->second;
+    auto pos = entry.position.find(id);
+    if (pos == entry.position.end()) {
+        return;
+    }
+
+    // 与末尾的订阅者交换后删除，发布顺序无关紧要
+    const size_t index = pos->second;
+    entry.position.erase(pos);
+    if (index + 1 != entry.members.size()) {
+        entry.members[index] = entry.members.back();
+        entry.position[entry.members[index]] = index;
+    }
+    entry.members.pop_back();
+
+    if (entry.members.empty()) {
+        stripe.topics.erase(it);
+    } else {
+        entry.snapshot.reset();
+    }
+}
+
+} // namespace KK_WS::server
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ws_server/server.hpp"
+#include <array>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace KK_WS::server {
+
+/**
+ * @brief 主题路由表（主题 -> 订阅者）
+ *
+ * 主题按哈希分散到多个分段，每个分段有独立的读写锁。
+ * 订阅变更在写锁下直接修改主题的订阅者数组（O(1)，删除时与末尾交换），
+ * 不复制整个列表；publish取得的是不可变快照，第一次在变更后取快照时
+ * 才按当前数组生成一份并缓存，复制的开销不超过随后发送本身。
+ * 大量连接连续订阅同一主题时总开销为O(N)，快照之后的发送不持有任何锁。
+ */
+class TopicRouter {
+public:
+    using SubscriberList = std::vector<connection_id>;
+    using SubscriberSnapshot = std::shared_ptr<const SubscriberList>;
+
+    /**
+     * @brief 订阅主题，已订阅时返回false
+     */
+    bool subscribe(connection_id id, const std::string& topic);
+
+    /**
+     * @brief 取消订阅，未订阅时返回false
+     */
+    bool unsubscribe(connection_id id, const std::string& topic);
+
+    /**
+     * @brief 移除连接的全部订阅（连接关闭时调用）
+     */
+    void remove_connection(connection_id id);
+
+    /**
+     * @brief 获取主题订阅者快照，无订阅者时返回nullptr
+     */
+    SubscriberSnapshot subscribers(const std::string& topic) const;
+
+    size_t subscriber_count(const std::string& topic) const;
+    size_t topic_count() const;
+
+private:
+    static constexpr size_t kStripeCount = 16;
+
+    struct Topic {
+        SubscriberList members;                             // 当前订阅者，写锁下修改
+        std::unordered_map<connection_id, size_t> position; // 订阅者在members中的下标
+        mutable SubscriberSnapshot snapshot;                // members变化后置空，取快照时重建
+    };
+
+    struct Stripe {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Topic> topics;
+    };
+
+    Stripe& stripe_for(const std::string& topic);
+    const Stripe& stripe_for(const std::string& topic) const;
+
+    // 在分段写锁下修改主题的订阅者数组
+    void add_subscriber(const std::string& topic, connection_id id);
+    void remove_subscriber(const std::string& topic, connection_id id);
+
+private:
+    std::array<Stripe, kStripeCount> stripes_;
+
+    // 连接 -> 已订阅主题，仅在订阅变更和连接关闭时访问
+    // 锁顺序：connections_mutex_ 先于分段锁
+    std::mutex connections_mutex_;
+    std::unordered_map<connection_id, std::set<std::string>> topics_by_connection_;
+};
+
+} // namespace KK_WS::server
@@ -0,0 +1,237 @@
+// 客户端发送路径的负载拷贝预算：拷贝 vs 移动 vs 共享缓冲区
+//
+// 统计发送线程和客户端事件循环线程上的全部堆分配（服务器线程不计入），
+// 每一轮发送后等服务器收齐消息、再排空客户端事件循环，才读取计数。
+// 负载大小的分配次数必须与预算完全一致，否则进程返回1。
+// 其余小对象分配（发送队列节点、websocketpp消息对象和写回调等）随写出批次变化，只输出不断言。
+
+#include "ws_server/server.hpp"
+#include "ws_client/client.hpp"
+#include "ws_core/io_pool.hpp"
+#include "ws_common/logger.hpp"
+#include <boost/asio/post.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMessages = 2000;
+constexpr size_t kMessageSize = 4096;
+constexpr uint16_t kPort = 9130;
+
+// 只统计打了标记的线程：发送线程和客户端事件循环线程
+thread_local bool t_tracked = false;
+std::atomic<bool> g_counting{false};
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_payload_allocations{0};  // 不小于负载大小的分配
+std::atomic<uint64_t> g_allocated_bytes{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (t_tracked && g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        if (size >= kMessageSize) {
+            g_payload_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+using namespace KK_WS;
+
+namespace {
+
+struct AllocCount {
+    uint64_t allocations = 0;
+    uint64_t payload_allocations = 0;
+    uint64_t bytes = 0;
+};
+
+// 在事件循环线程上执行f并等待完成
+template <typename F>
+void run_on(boost::asio::io_service& loop, F f) {
+    std::promise<void> done;
+    auto finished = done.get_future();
+    boost::asio::post(loop, [&f, &done]() {
+        f();
+        done.set_value();
+    });
+    finished.wait();
+}
+
+// 等待服务器收到的消息数达到expected，超时返回false
+bool wait_received(const std::atomic<uint64_t>& received, uint64_t expected) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received.load(std::memory_order_acquire) < expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/**
+ * @brief 统计send()及其在客户端事件循环上引发的全部分配
+ *
+ * 服务器收齐消息说明所有写操作都已完成；再向事件循环投递一次空任务，
+ * 确保写完成回调也已执行完，之后才停止计数。
+ */
+template <typename F>
+bool count_allocations(F&& send, boost::asio::io_service& loop,
+                       const std::atomic<uint64_t>& received, uint64_t expected,
+                       AllocCount& out) {
+    g_allocations = 0;
+    g_payload_allocations = 0;
+    g_allocated_bytes = 0;
+    g_counting = true;
+
+    send();
+    const bool drained = wait_received(received, expected);
+    run_on(loop, []() {});
+
+    g_counting = false;
+    out = {g_allocations.load(), g_payload_allocations.load(), g_allocated_bytes.load()};
+    return drained;
+}
+
+/**
+ * @brief 输出一种发送方式的结果，负载分配次数与预算不一致时返回false
+ * @param payload_budget 每条消息允许的负载大小分配次数
+ */
+bool check(const char* name, const AllocCount& c, uint64_t payload_budget) {
+    std::printf("%-22s %14.2f %14.2f %16.1f\n", name,
+                static_cast<double>(c.payload_allocations) / kMessages,
+                static_cast<double>(c.allocations) / kMessages,
+                static_cast<double>(c.bytes) / kMessages);
+    if (c.payload_allocations != payload_budget * kMessages) {
+        std::printf("失败: %s 负载分配 %llu 次，预算 %llu 次\n", name,
+                    static_cast<unsigned long long>(c.payload_allocations),
+                    static_cast<unsigned long long>(payload_budget * kMessages));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    Logger::set_level(Logger::Level::Ws_WARNING);
+
+    server::ServerConfig server_config;
+    server_config.port = kPort;
+    server_config.enable_logging = false;
+    server_config.io_threads = 1;
+
+    // 只计数不回复，客户端事件循环上不会出现接收路径的分配
+    std::atomic<uint64_t> received{0};
+    server::WebSocketServer srv(server_config);
+    srv.set_message_handler([&received](server::connection_hdl, const std::string&) {
+        received.fetch_add(1, std::memory_order_release);
+    });
+    std::thread server_thread([&srv]() { srv.start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto io_pool = std::make_shared<core::IoPool>(1);
+    boost::asio::io_service& loop = io_pool->at(0);
+    run_on(loop, []() { t_tracked = true; });
+    t_tracked = true;
+
+    client::ClientConfig client_config;
+    client_config.server_uri = "ws://127.0.0.1:" + std::to_string(kPort);
+    client_config.auto_reconnect = false;
+    client_config.ping_interval_ms = 0;
+
+    int exit_code = 0;
+    {
+        client::WebSocketClient client("alloc-test", io_pool);
+        if (!client.connect(client_config)) {
+            std::printf("连接失败: %s\n", client_config.server_uri.c_str());
+            srv.stop();
+            server_thread.join();
+            return 1;
+        }
+
+        const std::string payload(kMessageSize, 'x');
+        uint64_t expected = 0;
+
+        // 预热：让websocketpp的发送队列等内部容器完成扩容
+        for (size_t i = 0; i < 64; ++i) {
+            client.send_text(payload);
+        }
+        expected += 64;
+        if (!wait_received(received, expected)) {
+            std::printf("失败: 预热消息未全部送达\n");
+            exit_code = 1;
+        }
+
+        AllocCount copied;
+        expected += kMessages;
+        bool delivered = count_allocations([&]() {
+            for (size_t i = 0; i < kMessages; ++i) {
+                client.send_text(payload);
+            }
+        }, loop, received, expected, copied);
+
+        // 负载由调用方事先准备好，不计入发送路径
+        std::vector<std::string> owned(kMessages, payload);
+        AllocCount moved;
+        expected += kMessages;
+        delivered = count_allocations([&]() {
+            for (auto& p : owned) {
+                client.send_text(std::move(p));
+            }
+        }, loop, received, expected, moved) && delivered;
+
+        auto buffer = std::make_shared<const std::string>(payload);
+        AllocCount shared;
+        expected += kMessages;
+        delivered = count_allocations([&]() {
+            for (size_t i = 0; i < kMessages; ++i) {
+                client.send_message(ws_message::message_type::TEXT, buffer);
+            }
+        }, loop, received, expected, shared) && delivered;
+
+        std::printf("消息数: %zu, 消息大小: %zu 字节\n", kMessages, kMessageSize);
+        std::printf("%-22s %14s %14s %16s\n", "发送方式", "负载分配/条", "分配次数/条", "分配字节/条");
+
+        // 预算：拷贝接口复制一次负载；移动接口零拷贝；
+        // 共享缓冲区不能就地加掩码，只在进入发送队列时复制一次
+        bool ok = check("send_text(const&)", copied, 1);
+        ok = check("send_text(&&)", moved, 0) && ok;
+        ok = check("send_message(shared)", shared, 1) && ok;
+
+        if (!delivered) {
+            std::printf("失败: 服务器未在超时前收齐消息\n");
+            ok = false;
+        }
+        if (!ok) {
+            exit_code = 1;
+        }
+
+        client.disconnect();
+    }
+
+    srv.stop();
+    server_thread.join();
+    return exit_code;
+}